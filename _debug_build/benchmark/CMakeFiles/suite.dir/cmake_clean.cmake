@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/suite.dir/suite.cpp.o"
+  "CMakeFiles/suite.dir/suite.cpp.o.d"
+  "suite"
+  "suite.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/suite.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/wavelet_benchmark.dir/wavelet_benchmark.cpp.o"
+  "CMakeFiles/wavelet_benchmark.dir/wavelet_benchmark.cpp.o.d"
+  "wavelet_benchmark"
+  "wavelet_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/wavelet_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
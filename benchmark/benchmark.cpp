@@ -1,11 +1,24 @@
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <random>
+#include <string>
+#include <thread>
 
+#include <appendable_trit_vector.hpp>
+#include <dynamic_trit_vector.hpp>
+#include <fused_rs_support.hpp>
+#include <interleaved_rs_vector.hpp>
+#include <packed_rs_support.hpp>
+#include <rrr_rs_support.hpp>
 #include <rs_support.hpp>
+#include <streaming_builder.hpp>
 #include <trit_vector.hpp>
 
+#include "perf_counters.hpp"
+
 static constexpr uint64_t NUM_QUERIES = 100'000;
+static constexpr uint64_t SELECT_SAMPLE_RATE = 512;
 
 class timer {
   public:
@@ -34,6 +47,19 @@ std::vector<uint8_t> generate_trits(uint64_t num_trits) {
     return trits;
 }
 
+// Generates trits in which 0 appears with percent_zeros% and 1 and 2 evenly share the rest
+std::vector<uint8_t> generate_skewed_trits(uint64_t num_trits, uint32_t percent_zeros) {
+    std::default_random_engine engine(19);
+    std::uniform_int_distribution<uint32_t> dist(0, 199);
+
+    std::vector<uint8_t> trits(num_trits);
+    for (uint64_t i = 0; i < num_trits; ++i) {
+        const uint32_t x = dist(engine);
+        trits[i] = x < percent_zeros * 2 ? 0 : uint8_t(1 + x % 2);
+    }
+    return trits;
+}
+
 void benchmark_access(const succinctrits::trit_vector& tv) {
     std::random_device seed_gen;
     std::default_random_engine engine(seed_gen());
@@ -51,40 +77,722 @@ void benchmark_access(const succinctrits::trit_vector& tv) {
     std::cout << "# access time: " << elapsed_nanosec / NUM_QUERIES << " ns/op" << std::endl;
 }
 
-template <uint8_t Trit>
-void benchmark_rank(const succinctrits::rs_support<Trit>& tv_rs) {
+// Decodes all the trits sequentially by get(), extract() and const_iterator
+void benchmark_decode(const succinctrits::trit_vector& tv) {
+    const uint64_t num_trits = tv.get_num_trits();
+    std::vector<uint8_t> buf(num_trits);
+    uint64_t sum = 0;
+
+    auto report = [&](const char* label, double elapsed_nanosec) {
+        std::cout << "# decode time: " << elapsed_nanosec / num_trits << " ns/trit (" << label << ", "
+                  << num_trits / elapsed_nanosec << " Gtrits/s)" << std::endl;
+    };
+    {
+        timer t;
+        for (uint64_t i = 0; i < num_trits; ++i) {
+            buf[i] = tv[i];
+        }
+        report("get", t.get<std::chrono::nanoseconds>());
+        sum += buf[num_trits / 2];
+    }
+    {
+        timer t;
+        tv.extract(0, num_trits, buf.data());
+        report("extract", t.get<std::chrono::nanoseconds>());
+        sum += buf[num_trits / 2];
+    }
+    {
+        timer t;
+        uint64_t i = 0;
+        for (uint8_t trit : tv) {
+            buf[i++] = trit;
+        }
+        report("iterator", t.get<std::chrono::nanoseconds>());
+        sum += buf[num_trits / 2];
+    }
+    if (6 < sum) {  // to avoid opt.
+        std::cerr << "critical error" << std::endl;
+        exit(1);
+    }
+}
+
+// Compares listing the positions of 0s in the whole vector by get, select and find_occurrences
+void benchmark_occurrences(const succinctrits::trit_vector& tv, const succinctrits::rs_support<0>& tv_rs) {
+    const uint64_t num_trits = tv.get_num_trits();
+    std::vector<uint64_t> positions(tv_rs.get_num_target_trits());
+    uint64_t sum = 0;
+
+    auto report = [&](const char* label, double elapsed_nanosec) {
+        std::cout << "# occurrence listing time: " << elapsed_nanosec / positions.size() << " ns/occurrence ("
+                  << label << ")" << std::endl;
+    };
+    {
+        timer t;
+        uint64_t n = 0;
+        for (uint64_t i = 0; i < num_trits; ++i) {
+            if (tv[i] == 0) {
+                positions[n++] = i;
+            }
+        }
+        report("get", t.get<std::chrono::nanoseconds>());
+        sum += positions[n / 2];
+    }
+    {
+        timer t;
+        for (uint64_t n = 0; n < positions.size(); ++n) {
+            positions[n] = tv_rs.select(n);
+        }
+        report("select", t.get<std::chrono::nanoseconds>());
+        sum += positions[positions.size() / 2];
+    }
+    {
+        timer t;
+        tv.find_occurrences<0>(0, num_trits, positions.begin());
+        report("find_occurrences", t.get<std::chrono::nanoseconds>());
+        sum += positions[positions.size() / 2];
+    }
+    if (sum == 0) {  // to avoid opt.
+        std::cerr << "critical error" << std::endl;
+        exit(1);
+    }
+}
+
+template <uint8_t Trit, bool Scalar>
+void benchmark_rank(const succinctrits::rs_support<Trit>& tv_rs, const char* label = "") {
     std::random_device seed_gen;
     std::default_random_engine engine(seed_gen());
     std::uniform_int_distribution<uint64_t> dist(0, tv_rs.get_num_trits() - 1);
 
     timer t;
     for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
-        uint64_t rank = tv_rs.rank(dist(engine));
+        uint64_t rank = Scalar ? tv_rs.rank_scalar(dist(engine)) : tv_rs.rank(dist(engine));
         if (tv_rs.get_num_target_trits() < rank) {  // to avoid opt.
             std::cerr << "critical error" << std::endl;
             exit(1);
         }
     }
     const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
-    std::cout << "# rank time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op" << std::endl;
+    std::cout << "# rank time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op" << (Scalar ? " (scalar)" : "")
+              << label << std::endl;
 }
 
-template <uint8_t Trit>
-void benchmark_select(const succinctrits::rs_support<Trit>& tv_rs) {
+template <uint8_t Trit, bool Scalar>
+void benchmark_select(const succinctrits::rs_support<Trit>& tv_rs, const char* label = "") {
     std::random_device seed_gen;
     std::default_random_engine engine(seed_gen());
     std::uniform_int_distribution<uint64_t> dist(0, tv_rs.get_num_target_trits() - 1);
 
     timer t;
     for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
-        uint64_t select = tv_rs.select(dist(engine));
+        uint64_t select = Scalar ? tv_rs.select_scalar(dist(engine)) : tv_rs.select(dist(engine));
         if (tv_rs.get_num_trits() <= select) {  // to avoid opt.
             std::cerr << "critical error" << std::endl;
             exit(1);
         }
     }
     const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
-    std::cout << "# select time: " << elapsed_nanosec / NUM_QUERIES << " ns/op" << std::endl;
+    std::cout << "# select time: " << elapsed_nanosec / NUM_QUERIES << " ns/op" << (Scalar ? " (scalar)" : "")
+              << label << std::endl;
+}
+
+std::vector<uint64_t> generate_queries(uint64_t max_value) {
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint64_t> dist(0, max_value - 1);
+
+    std::vector<uint64_t> queries(NUM_QUERIES);
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        queries[i] = dist(engine);
+    }
+    return queries;
+}
+
+void benchmark_access_batch(const succinctrits::trit_vector& tv) {
+    const auto queries = generate_queries(tv.get_num_trits());
+    std::vector<uint8_t> trits(NUM_QUERIES);
+
+    timer t;
+    tv.access_batch(queries.data(), NUM_QUERIES, trits.data());
+    const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::cout << "# access time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (batch)" << std::endl;
+}
+
+template <uint8_t Trit>
+void benchmark_rank_batch(const succinctrits::rs_support<Trit>& tv_rs) {
+    const auto queries = generate_queries(tv_rs.get_num_trits());
+    std::vector<uint64_t> ranks(NUM_QUERIES);
+
+    timer t;
+    tv_rs.rank_batch(queries.data(), NUM_QUERIES, ranks.data());
+    const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::cout << "# rank time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op (batch)" << std::endl;
+}
+
+template <uint8_t Trit>
+void benchmark_select_batch(const succinctrits::rs_support<Trit>& tv_rs, const char* label = "") {
+    const auto queries = generate_queries(tv_rs.get_num_target_trits());
+    std::vector<uint64_t> positions(NUM_QUERIES);
+
+    timer t;
+    tv_rs.select_batch(queries.data(), NUM_QUERIES, positions.data());
+    const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::cout << "# select time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (batch)" << label << std::endl;
+}
+
+void benchmark_rank_all(const succinctrits::fused_rs_support& tv_rs) {
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint64_t> dist(0, tv_rs.get_num_trits() - 1);
+
+    timer t;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        auto ranks = tv_rs.rank_all(dist(engine));
+        if (tv_rs.get_num_trits() < ranks[0] + ranks[1]) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+    }
+    const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::cout << "# rank_all time: " << elapsed_nanosec / NUM_QUERIES << " ns/op" << std::endl;
+}
+
+// Compares the predicate rank/select on fused_rs_support with combining two rs_support objects
+void benchmark_predicates(const succinctrits::trit_vector& tv, const succinctrits::fused_rs_support& tv_rs) {
+    using namespace succinctrits;
+    const rs_support<0> rs_0(&tv);
+    const rs_support<1> rs_1(&tv);
+    const rs_support<2> rs_2(&tv);
+
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint64_t> rank_dist(0, tv.get_num_trits() - 1);
+    std::uniform_int_distribution<uint64_t> select_dist(0, tv_rs.get_num_target_trits_if<trit_ne<2>>() - 1);
+
+    uint64_t sum = 0;  // to avoid opt.
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            const uint64_t pos = rank_dist(engine);
+            sum += rs_0.rank(pos) + rs_1.rank(pos);
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# rank_0 + rank_1 time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (two rs_support)"
+                  << std::endl;
+    }
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += tv_rs.rank_if<trit_lt<2>>(rank_dist(engine));
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# rank_if<trit_lt<2>> time: " << elapsed_nanosec / NUM_QUERIES << " ns/op" << std::endl;
+    }
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += tv_rs.select_if<trit_ne<2>>(select_dist(engine));
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# select_if<trit_ne<2>> time: " << elapsed_nanosec / NUM_QUERIES << " ns/op" << std::endl;
+    }
+    {
+        std::uniform_int_distribution<uint64_t> dist(0, rs_2.get_num_target_trits() - 1);
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += rs_2.select(dist(engine));
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# select_2 time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (rs_support, for reference)"
+                  << std::endl;
+    }
+    if (sum == 0) {
+        std::cerr << "critical error" << std::endl;
+        exit(1);
+    }
+}
+
+void benchmark_build(const std::vector<uint8_t>& trits) {
+    const uint64_t num_threads = std::max<uint64_t>(1, std::thread::hardware_concurrency());
+    {
+        timer t;
+        succinctrits::trit_vector::builder b;
+        for (uint8_t trit : trits) {
+            b.push_back(trit);
+        }
+        succinctrits::trit_vector tv(&b);
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# encode time: " << elapsed_nanosec / trits.size() << " ns/trit (push_back)" << std::endl;
+    }
+    {
+        timer t;
+        succinctrits::trit_vector tv;
+        tv.build_from_span(trits.data(), trits.size());
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# encode time: " << elapsed_nanosec / trits.size() << " ns/trit (span)" << std::endl;
+    }
+    {
+        timer t;
+        succinctrits::trit_vector tv(trits.begin(), trits.size());
+        succinctrits::rs_support<0> tv_rs_0(&tv);
+        succinctrits::rs_support<1> tv_rs_1(&tv);
+        succinctrits::rs_support<2> tv_rs_2(&tv);
+        const double elapsed_millisec = t.get<std::chrono::microseconds>() / 1000.0;
+        std::cout << "# build time:  " << elapsed_millisec << " ms (serial, 3 indexes)" << std::endl;
+    }
+    {
+        timer t;
+        succinctrits::trit_vector tv(trits.begin(), trits.size(), num_threads);
+        succinctrits::rs_support<0> tv_rs_0;
+        succinctrits::rs_support<1> tv_rs_1;
+        succinctrits::rs_support<2> tv_rs_2;
+        succinctrits::build_rs_supports(&tv, &tv_rs_0, &tv_rs_1, &tv_rs_2, num_threads);
+        const double elapsed_millisec = t.get<std::chrono::microseconds>() / 1000.0;
+        std::cout << "# build time:  " << elapsed_millisec << " ms (" << num_threads << " threads, 3 indexes)"
+                  << std::endl;
+    }
+}
+
+// Compares appending the last chunk of trits with rebuilding the whole index
+void benchmark_append(const std::vector<uint8_t>& trits) {
+    static constexpr uint64_t CHUNK_SIZE = 1'000'000;
+    const uint64_t last = trits.size() - CHUNK_SIZE;
+
+    succinctrits::appendable_trit_vector atv;
+    atv.append(trits.data(), last);
+    {
+        timer t;
+        atv.append(trits.data() + last, CHUNK_SIZE);
+        const double elapsed_millisec = t.get<std::chrono::microseconds>() / 1000.0;
+        std::cout << "# append time: " << elapsed_millisec << " ms per " << CHUNK_SIZE << " trits (appendable)"
+                  << std::endl;
+    }
+    {
+        timer t;
+        succinctrits::trit_vector tv;
+        tv.build_from_span(trits.data(), trits.size());
+        succinctrits::fused_rs_support tv_rs(&tv);
+        const double elapsed_millisec = t.get<std::chrono::microseconds>() / 1000.0;
+        std::cout << "# append time: " << elapsed_millisec << " ms per " << CHUNK_SIZE << " trits (rebuild)"
+                  << std::endl;
+    }
+
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint64_t> dist(0, atv.get_num_trits() - 1);
+
+    timer t;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        auto ranks = atv.rank_all(dist(engine));
+        if (atv.get_num_trits() < ranks[0] + ranks[1]) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+    }
+    const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::cout << "# rank_all time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (appendable)" << std::endl;
+}
+
+// Compares point updates on dynamic_trit_vector with rebuilding trit_vector and fused_rs_support
+void benchmark_dynamic(std::vector<uint8_t> trits) {
+    succinctrits::trit_vector tv;
+    tv.build_from_span(trits.data(), trits.size());
+    succinctrits::dynamic_trit_vector dtv(tv);
+
+    const auto positions = generate_queries(trits.size());
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            dtv.set(positions[i], uint8_t(i % 3));
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# set time:    " << elapsed_nanosec / NUM_QUERIES << " ns/op (dynamic)" << std::endl;
+    }
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            trits[positions[i]] = uint8_t(i % 3);
+        }
+        tv.build_from_span(trits.data(), trits.size());
+        succinctrits::fused_rs_support tv_rs(&tv);
+        const double elapsed_millisec = t.get<std::chrono::microseconds>() / 1000.0;
+        std::cout << "# set time:    " << elapsed_millisec << " ms per rebuild" << std::endl;
+    }
+
+    timer t;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        auto ranks = dtv.rank_all(positions[i]);
+        if (dtv.get_num_trits() < ranks[0] + ranks[1]) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+    }
+    double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::cout << "# rank_all time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (dynamic)" << std::endl;
+
+    const uint64_t num_zeros = dtv.get_num_target_trits<0>();
+    timer t2;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        if (dtv.get_num_trits() <= dtv.select<0>(positions[i] % num_zeros)) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+    }
+    elapsed_nanosec = t2.get<std::chrono::nanoseconds>();
+    std::cout << "# select time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (dynamic)" << std::endl;
+    std::cout << "# dynamic_trit_vector: " << dtv.size_in_bytes() * 8.0 / dtv.get_num_trits() << " bits/trit"
+              << std::endl;
+}
+
+template <class Packing>
+void benchmark_packing(const std::vector<uint8_t>& trits) {
+    succinctrits::packed_trit_vector<Packing> ptv(trits.begin(), trits.size());
+    succinctrits::packed_rs_support<0, Packing> rs(&ptv);
+    const char* name = Packing::name();
+
+    const auto positions = generate_queries(trits.size());
+    {
+        timer t;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += ptv[positions[i]];
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        if (sum > 2 * NUM_QUERIES) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        std::cout << "# access time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (" << name << ")" << std::endl;
+    }
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            if (rs.rank(positions[i]) > positions[i]) {  // to avoid opt.
+                std::cerr << "critical error" << std::endl;
+                exit(1);
+            }
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# rank time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op (" << name << ")" << std::endl;
+    }
+    {
+        const uint64_t num_zeros = rs.get_num_target_trits();
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            if (rs.select(positions[i] % num_zeros) >= trits.size()) {  // to avoid opt.
+                std::cerr << "critical error" << std::endl;
+                exit(1);
+            }
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# select time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (" << name << ")" << std::endl;
+    }
+    std::cout << "# packed_trit_vector: " << ptv.size_in_bytes() * 8.0 / trits.size() << " bits/trit (" << name
+              << ")" << std::endl;
+    std::cout << "# packed_rs_support:  " << rs.size_in_bytes() * 8.0 / trits.size() << " bits/trit (" << name
+              << ")" << std::endl;
+}
+
+// Measures Vector and RSSupport on 0s, which have the interfaces of trit_vector and rs_support
+template <class Vector, class RSSupport>
+void benchmark_vector(const std::vector<uint8_t>& trits, const char* label) {
+    Vector vec(trits.begin(), trits.size());
+    RSSupport rs(&vec);
+
+    const auto positions = generate_queries(trits.size());
+    {
+        timer t;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += vec[positions[i]];
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        if (sum > 2 * NUM_QUERIES) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        std::cout << "# access time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (" << label << ")" << std::endl;
+    }
+    {
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            if (rs.rank(positions[i]) > positions[i]) {  // to avoid opt.
+                std::cerr << "critical error" << std::endl;
+                exit(1);
+            }
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# rank time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op (" << label << ")" << std::endl;
+    }
+    {
+        const uint64_t num_zeros = rs.get_num_target_trits();
+        timer t;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            if (rs.select(positions[i] % num_zeros) >= trits.size()) {  // to avoid opt.
+                std::cerr << "critical error" << std::endl;
+                exit(1);
+            }
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        std::cout << "# select time: " << elapsed_nanosec / NUM_QUERIES << " ns/op (" << label << ")" << std::endl;
+    }
+    std::cout << "# vector:     " << vec.size_in_bytes() * 8.0 / trits.size() << " bits/trit (" << label << ")"
+              << std::endl;
+    std::cout << "# rs_support: " << rs.size_in_bytes() * 8.0 / trits.size() << " bits/trit (" << label << ")"
+              << std::endl;
+}
+
+// Compares trit_vector and rrr_trit_vector on skewed trits
+void benchmark_compressed(uint64_t num_trits) {
+    for (uint32_t percent_zeros : {34, 90, 95, 99}) {
+        std::cout << "# --- " << percent_zeros << "% of 0s ---" << std::endl;
+        const auto trits = generate_skewed_trits(num_trits, percent_zeros);
+        benchmark_vector<succinctrits::trit_vector, succinctrits::rs_support<0>>(trits, "plain");
+        benchmark_vector<succinctrits::rrr_trit_vector, succinctrits::rrr_rs_support<0>>(trits, "rrr");
+    }
+}
+
+// Builds the container file of the vector and the three indexes by streaming_builder
+void benchmark_streaming(const std::vector<uint8_t>& trits) {
+    const char* file_name = "benchmark_streaming.idx";
+    timer t;
+    succinctrits::streaming_builder b(file_name);
+    b.append(trits.data(), trits.size());
+    const uint64_t bytes = b.size_in_bytes();
+    b.finish();
+    const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+    std::remove(file_name);
+    std::cout << "# encode time: " << elapsed_nanosec / trits.size() << " ns/trit (streaming to a file, "
+              << bytes * 8.0 / trits.size() << " bits/trit in memory)" << std::endl;
+}
+
+// Trade-off between the space and the query time of the block parameters of rs_support
+void benchmark_block_params(const std::vector<uint8_t>& trits) {
+    using succinctrits::rs_support;
+    using succinctrits::trit_vector;
+    benchmark_vector<trit_vector, rs_support<0, 65500, 100>>(trits, "LB=65500, SB=100");
+    benchmark_vector<trit_vector, rs_support<0, 65520, 70>>(trits, "LB=65520, SB=70");
+    benchmark_vector<trit_vector, rs_support<0>>(trits, "LB=65550, SB=50");
+    benchmark_vector<trit_vector, rs_support<0, 65520, 30>>(trits, "LB=65520, SB=30");
+    benchmark_vector<trit_vector, rs_support<0, 250, 25, uint8_t>>(trits, "LB=250, SB=25, 8-bit");
+    benchmark_vector<trit_vector, rs_support<0, 255, 15, uint8_t>>(trits, "LB=255, SB=15, 8-bit");
+}
+
+// Compares next() and prev() with rank() followed by select()
+template <uint8_t Trit>
+void benchmark_next_prev(const succinctrits::rs_support<Trit>& tv_rs, const char* label = "") {
+    const auto positions = generate_queries(tv_rs.get_num_trits());
+    const uint64_t num_trits = tv_rs.get_num_trits();
+    {
+        timer t;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += tv_rs.next(positions[i]);
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        if (sum == 0) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        std::cout << "# next time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op" << label << std::endl;
+    }
+    {
+        timer t;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            const uint64_t n = tv_rs.rank(positions[i]);
+            sum += n < tv_rs.get_num_target_trits() ? tv_rs.select(n) : num_trits;
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        if (sum == 0) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        std::cout << "# next time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op by rank+select" << label
+                  << std::endl;
+    }
+    {
+        timer t;
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += tv_rs.prev(positions[i]);
+        }
+        const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+        if (sum == 0) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        std::cout << "# prev time:   " << elapsed_nanosec / NUM_QUERIES << " ns/op" << label << std::endl;
+    }
+}
+
+// Compares the dense and sparse layouts of rs_support<2> where 2s are rare
+void benchmark_sparse(uint64_t num_trits) {
+    for (uint32_t percent_zeros : {90, 99}) {
+        const auto trits = generate_skewed_trits(num_trits, percent_zeros);
+        succinctrits::trit_vector tv(trits.begin(), trits.size());
+        succinctrits::rs_support<2> dense(&tv, succinctrits::rs_layout::dense);
+        succinctrits::rs_support<2> sparse(&tv, succinctrits::rs_layout::sparse);
+
+        std::cout << "# --- " << (100 - percent_zeros) / 2.0 << "% of 2s ---" << std::endl;
+        benchmark_rank<2, false>(dense, " (dense)");
+        benchmark_rank<2, false>(sparse, " (sparse)");
+        benchmark_select<2, false>(dense, " (dense)");
+        benchmark_select<2, false>(sparse, " (sparse)");
+        benchmark_next_prev(dense, " (dense)");
+        benchmark_next_prev(sparse, " (sparse)");
+        std::cout << "# rs_support:  " << dense.size_in_bytes() * 8.0 / num_trits << " bits/trit (dense)" << std::endl;
+        std::cout << "# rs_support:  " << sparse.size_in_bytes() * 8.0 / num_trits << " bits/trit (sparse)"
+                  << std::endl;
+    }
+}
+
+// Compares the cache-line-interleaved layout with the pair of trit_vector and rs_support
+void benchmark_interleaved(const std::vector<uint8_t>& trits) {
+    succinctrits::interleaved_rs_vector<0> irv(trits.begin(), trits.size());
+    const auto positions = generate_queries(trits.size());
+    const auto ns = generate_queries(irv.get_num_target_trits());
+
+    uint64_t sum = 0;
+    timer t1;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += irv[positions[i]];
+    }
+    const double access_time = t1.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+    timer t2;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += irv.rank(positions[i]);
+    }
+    const double rank_time = t2.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+    timer t3;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += irv.select(ns[i]);
+    }
+    const double select_time = t3.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+    if (sum == 0) {  // to avoid opt.
+        std::cerr << "critical error" << std::endl;
+        exit(1);
+    }
+
+    std::cout << "# access time: " << access_time << " ns/op (interleaved)" << std::endl;
+    std::cout << "# rank time:   " << rank_time << " ns/op (interleaved)" << std::endl;
+    std::cout << "# select time: " << select_time << " ns/op (interleaved)" << std::endl;
+    std::cout << "# interleaved_rs_vector: " << irv.size_in_bytes() * 8.0 / trits.size() << " bits/trit"
+              << std::endl;
+}
+
+// Compares the random-access latency with the arrays in each memory resource
+void benchmark_placement(const std::vector<uint8_t>& trits) {
+    succinctrits::huge_page_resource huge_2mb(succinctrits::huge_page_resource::SIZE_2MB);
+    succinctrits::huge_page_resource huge_1gb(succinctrits::huge_page_resource::SIZE_1GB);
+    succinctrits::numa_resource numa_interleave(succinctrits::numa_resource::policy::interleave);
+    succinctrits::numa_resource numa_local(succinctrits::numa_resource::policy::local);
+    const std::pair<const char*, succinctrits::memory_resource*> resources[] = {
+        {"default", nullptr},
+        {"huge pages 2MB", &huge_2mb},
+        {"huge pages 1GB", &huge_1gb},
+        {"NUMA interleave", &numa_interleave},
+        {"NUMA local", &numa_local},
+    };
+
+    const auto positions = generate_queries(trits.size());
+    for (const auto& r : resources) {
+        succinctrits::trit_vector tv(trits.begin(), trits.size());
+        succinctrits::rs_support<0> tv_rs(&tv);
+        if (r.second != nullptr) {
+            tv.relocate(r.second);
+            tv_rs.relocate(r.second);
+        }
+
+        uint64_t sum = 0;
+        timer t1;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += tv[positions[i]];
+        }
+        const double access_time = t1.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+        timer t2;
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += tv_rs.rank(positions[i]);
+        }
+        const double rank_time = t2.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+        if (sum == 0) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        std::cout << "# access time: " << access_time << " ns/op, rank time: " << rank_time << " ns/op (" << r.first
+                  << ")" << std::endl;
+    }
+    std::cout << "# huge pages:  " << huge_2mb.get_num_huge_pages() + huge_1gb.get_num_huge_pages()
+              << " allocations by MAP_HUGETLB, " << huge_2mb.get_num_fallbacks() + huge_1gb.get_num_fallbacks()
+              << " by MADV_HUGEPAGE" << std::endl;
+    std::cout << "# NUMA:        " << numa_interleave.get_num_bound() + numa_local.get_num_bound()
+              << " allocations bound by mbind" << std::endl;
+}
+
+// Reports the hardware counters and, if SUCCINCTRITS_ENABLE_STATS is defined, the work of the
+// hot paths per operation
+template <uint8_t Trit>
+void benchmark_counters(const succinctrits::trit_vector& tv, const succinctrits::rs_support<Trit>& tv_rs) {
+    const auto positions = generate_queries(tv.get_num_trits());
+    const auto ns = generate_queries(tv_rs.get_num_target_trits());
+
+    auto measure = [&](const char* label, auto query) {
+        perf_counters counters;
+        succinctrits::stats::get().reset();
+        uint64_t sum = 0;
+        counters.start();
+        for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+            sum += query(i);
+        }
+        counters.stop();
+        if (sum == 0) {  // to avoid opt.
+            std::cerr << "critical error" << std::endl;
+            exit(1);
+        }
+        counters.print(std::cout, NUM_QUERIES, label);
+        if (succinctrits::stats::enabled()) {
+            succinctrits::stats::get().print(std::cout);
+        }
+    };
+    measure("access", [&](uint64_t i) { return tv[positions[i]] + 1; });
+    measure("rank", [&](uint64_t i) { return tv_rs.rank(positions[i]) + 1; });
+    measure("select", [&](uint64_t i) { return tv_rs.select(ns[i]); });
+}
+
+// Compares the kernels of every ISA supported by the CPU
+template <uint8_t Trit>
+void benchmark_dispatch(const std::vector<uint8_t>& trits, const succinctrits::trit_vector& tv,
+                        const succinctrits::rs_support<Trit>& tv_rs) {
+    using succinctrits::isa;
+    std::vector<uint8_t> buf(trits.size());
+
+    for (isa x : {isa::scalar, isa::sse42, isa::avx2, isa::avx512bw}) {
+        if (!succinctrits::set_isa(x)) {
+            continue;
+        }
+        const std::string label = std::string(" (") + succinctrits::to_string(x) + ")";
+        benchmark_rank<Trit, false>(tv_rs, label.c_str());
+        benchmark_select<Trit, false>(tv_rs, label.c_str());
+        {
+            timer t;
+            succinctrits::trit_vector encoded;
+            encoded.build_from_span(trits.data(), trits.size());
+            const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+            std::cout << "# encode time: " << elapsed_nanosec / trits.size() << " ns/trit (span" << label << ")"
+                      << std::endl;
+        }
+        {
+            timer t;
+            tv.extract(0, tv.get_num_trits(), buf.data());
+            const double elapsed_nanosec = t.get<std::chrono::nanoseconds>();
+            std::cout << "# decode time: " << elapsed_nanosec / trits.size() << " ns/trit (extract" << label << ")"
+                      << std::endl;
+            if (buf != trits) {  // to avoid opt.
+                std::cerr << "critical error" << std::endl;
+                exit(1);
+            }
+        }
+    }
+    succinctrits::set_isa(succinctrits::detect_isa());
 }
 
 int main() {
@@ -96,14 +804,49 @@ int main() {
         auto trits = generate_trits(num_trits);
         succinctrits::trit_vector tv(trits.begin(), trits.size());
         succinctrits::rs_support<0> tv_rs(&tv);
+        succinctrits::rs_support<0> tv_rs_sampled(&tv, SELECT_SAMPLE_RATE);
+        succinctrits::fused_rs_support tv_fused_rs(&tv);
 
         benchmark_access(tv);
-        benchmark_rank(tv_rs);
-        benchmark_select(tv_rs);
+        benchmark_decode(tv);
+        benchmark_occurrences(tv, tv_rs);
+        benchmark_rank<0, true>(tv_rs);
+        benchmark_select<0, true>(tv_rs);
+        std::cout << "# SIMD kernels: " << succinctrits::to_string(succinctrits::get_isa()) << std::endl;
+        benchmark_rank<0, false>(tv_rs);
+        benchmark_select<0, false>(tv_rs);
+        benchmark_select<0, true>(tv_rs_sampled, " (sampled)");
+        benchmark_select<0, false>(tv_rs_sampled, " (sampled)");
+        benchmark_access_batch(tv);
+        benchmark_rank_batch(tv_rs);
+        benchmark_select_batch(tv_rs);
+        benchmark_select_batch(tv_rs_sampled, " (sampled)");
+        benchmark_rank_all(tv_fused_rs);
+        benchmark_predicates(tv, tv_fused_rs);
+        benchmark_next_prev(tv_rs);
+        benchmark_counters(tv, tv_rs);
+        benchmark_dispatch(trits, tv, tv_rs);
+        benchmark_block_params(trits);
+        benchmark_placement(trits);
+        benchmark_interleaved(trits);
+        benchmark_build(trits);
+        benchmark_streaming(trits);
+        benchmark_append(trits);
+        benchmark_dynamic(trits);
+        benchmark_packing<succinctrits::tryte_packing>(trits);
+        benchmark_packing<succinctrits::spill_packing>(trits);
+        benchmark_compressed(num_trits);
+        benchmark_sparse(num_trits);
 
         const double tv_size_in_bits = tv.size_in_bytes() * 8.0;
         const double rs_size_in_bits = tv_rs.size_in_bytes() * 8.0;
+        const double rs_sampled_size_in_bits = tv_rs_sampled.size_in_bytes() * 8.0;
+        const double fused_rs_size_in_bits = tv_fused_rs.size_in_bytes() * 8.0;
         std::cout << "# trit_vector: " << tv_size_in_bits / tv.get_num_trits() << " bits/trit" << std::endl;
         std::cout << "# rs_support:  " << rs_size_in_bits / tv.get_num_trits() << " bits/trit" << std::endl;
+        std::cout << "# rs_support:  " << rs_sampled_size_in_bits / tv.get_num_trits() << " bits/trit (sampled)"
+                  << std::endl;
+        std::cout << "# fused_rs_support: " << fused_rs_size_in_bits / tv.get_num_trits() << " bits/trit"
+                  << std::endl;
     }
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware counters of the calling thread via Linux perf_event_open, counted in user space only.
+// The counters that cannot be opened (e.g., on other OSes, in VMs without a PMU, or with a strict
+// kernel.perf_event_paranoid) are reported as unavailable.
+class perf_counters {
+  public:
+    enum event : int { CACHE_MISSES, DTLB_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+    perf_counters() {
+        std::fill(m_fds, m_fds + NUM_EVENTS, -1);
+        std::fill(m_values, m_values + NUM_EVENTS, uint64_t(0));
+#ifdef __linux__
+        m_fds[CACHE_MISSES] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        m_fds[DTLB_MISSES] = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |  //
+                                                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |  //
+                                                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        m_fds[BRANCH_MISSES] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+    }
+    ~perf_counters() {
+#ifdef __linux__
+        for (int fd : m_fds) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    void start() {
+#ifdef __linux__
+        for (int fd : m_fds) {
+            if (fd != -1) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+    void stop() {
+#ifdef __linux__
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            if (m_fds[e] != -1) {
+                ioctl(m_fds[e], PERF_EVENT_IOC_DISABLE, 0);
+                if (read(m_fds[e], &m_values[e], sizeof(uint64_t)) != sizeof(uint64_t)) {
+                    m_values[e] = 0;
+                }
+            }
+        }
+#endif
+    }
+
+    bool available(event e) const {
+        return m_fds[e] != -1;
+    }
+    // Returns the count between the last start() and stop().
+    uint64_t get(event e) const {
+        return m_values[e];
+    }
+
+    // Prints the counts divided by num_ops.
+    void print(std::ostream& os, uint64_t num_ops, const char* label) const {
+        static const char* names[NUM_EVENTS] = {"cache-misses", "dTLB-misses", "branch-misses"};
+        os << "# counters:    " << label << ":";
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            os << " " << names[e] << " = ";
+            if (available(event(e))) {
+                os << double(m_values[e]) / num_ops << "/op";
+            } else {
+                os << "n/a";
+            }
+        }
+        os << std::endl;
+    }
+
+  private:
+    int m_fds[NUM_EVENTS];
+    uint64_t m_values[NUM_EVENTS];
+
+#ifdef __linux__
+    static int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = type;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+};
@@ -0,0 +1,394 @@
+// Benchmark suite for regression tracking and hardware sizing.
+//
+// It runs every combination of vector size, trit distribution, target trit, operation and query
+// pattern with fixed seeds, and writes the latency percentiles and the throughput in JSON.
+//
+//   $ ./suite --min-trits 1000 --max-trits 100000000 --queries 100000 --json suite.json
+//
+// Sizes grow tenfold from --min-trits to --max-trits, e.g., --max-trits 20000000000 for 4 GB of trits.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rs_support.hpp>
+#include <trit_vector.hpp>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct options {
+    uint64_t min_trits = 1'000;  // fits in L1
+    uint64_t max_trits = 100'000'000;
+    uint64_t num_queries = 100'000;
+    std::string json_path = "suite.json";
+    std::string tmp_path = "suite.tmp";  // for save and load
+};
+
+enum class distribution { uniform, skewed, runs };
+enum class pattern { random, sequential, clustered };
+
+const char* to_string(distribution d) {
+    switch (d) {
+        case distribution::uniform:
+            return "uniform";
+        case distribution::skewed:
+            return "skewed";
+        case distribution::runs:
+            return "runs";
+    }
+    return "";
+}
+const char* to_string(pattern p) {
+    switch (p) {
+        case pattern::random:
+            return "random";
+        case pattern::sequential:
+            return "sequential";
+        case pattern::clustered:
+            return "clustered";
+    }
+    return "";
+}
+
+// Generates trits in chunks with a fixed seed, so that vectors larger than memory for a byte per
+// trit can be built.
+//  - uniform: 0, 1 and 2 with the same probability
+//  - skewed: 0 with 90%, and 1 and 2 with 5% each
+//  - runs: runs of the same trit whose lengths follow a geometric distribution with mean 64
+class trit_generator {
+  public:
+    trit_generator(distribution dist, uint64_t seed) : m_dist(dist), m_engine(seed) {}
+
+    void generate(uint8_t* trits, uint64_t num) {
+        for (uint64_t i = 0; i < num; ++i) {
+            trits[i] = next();
+        }
+    }
+
+  private:
+    distribution m_dist;
+    std::mt19937_64 m_engine;
+    uint64_t m_bits = 0;
+    uint64_t m_num_bits = 0;  // number of trits or percents left in m_bits
+    uint8_t m_run_trit = 0;
+
+    uint8_t next() {
+        switch (m_dist) {
+            case distribution::uniform: {
+                if (m_num_bits == 0) {
+                    m_bits = m_engine() >> 1;  // 39 trits from 63 bits are almost uniform
+                    m_num_bits = 39;
+                }
+                --m_num_bits;
+                const uint8_t t = uint8_t(m_bits % 3);
+                m_bits /= 3;
+                return t;
+            }
+            case distribution::skewed: {
+                const uint64_t x = m_engine() % 100;
+                return x < 90 ? 0 : (x < 95 ? 1 : 2);
+            }
+            case distribution::runs: {
+                if (m_engine() % 64 == 0) {
+                    m_run_trit = uint8_t(m_engine() % 3);
+                }
+                return m_run_trit;
+            }
+        }
+        return 0;
+    }
+};
+
+// Returns num queries in [0, max_value) following the pattern.
+std::vector<uint64_t> generate_queries(pattern p, uint64_t max_value, uint64_t num, uint64_t seed) {
+    std::mt19937_64 engine(seed);
+    std::vector<uint64_t> queries(num);
+    if (max_value == 0) {
+        return {};
+    }
+    switch (p) {
+        case pattern::random:
+            for (uint64_t i = 0; i < num; ++i) {
+                queries[i] = engine() % max_value;
+            }
+            break;
+        case pattern::sequential: {
+            const uint64_t beg = engine() % max_value;
+            for (uint64_t i = 0; i < num; ++i) {
+                queries[i] = (beg + i) % max_value;
+            }
+            break;
+        }
+        case pattern::clustered: {
+            // 64 queries within 4096 positions around each random center
+            uint64_t center = 0;
+            for (uint64_t i = 0; i < num; ++i) {
+                if (i % 64 == 0) {
+                    center = engine() % max_value;
+                }
+                queries[i] = (center + engine() % 4096) % max_value;
+            }
+            break;
+        }
+    }
+    return queries;
+}
+
+struct query_stats {
+    double p50_ns = 0.0;
+    double p99_ns = 0.0;
+    double p999_ns = 0.0;
+    double mean_ns = 0.0;  // from the loop without per-query timing
+    double mops = 0.0;  // million queries per second
+};
+
+volatile uint64_t g_sink = 0;  // to avoid optimizing the queries away
+
+// Returns the median cost of reading the clock twice, which is subtracted from every latency.
+double get_timer_overhead_ns() {
+    std::vector<double> samples(10000);
+    for (double& x : samples) {
+        const auto beg = clock_type::now();
+        const auto end = clock_type::now();
+        x = std::chrono::duration<double, std::nano>(end - beg).count();
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+template <class Query>
+query_stats measure(const std::vector<uint64_t>& queries, double timer_overhead_ns, Query query) {
+    query_stats stats;
+    if (queries.empty()) {
+        return stats;
+    }
+
+    uint64_t sum = 0;
+    const auto beg = clock_type::now();
+    for (uint64_t q : queries) {
+        sum += query(q);
+    }
+    const double total_ns = std::chrono::duration<double, std::nano>(clock_type::now() - beg).count();
+    stats.mean_ns = total_ns / queries.size();
+    stats.mops = 1000.0 / stats.mean_ns;
+
+    std::vector<double> latencies(queries.size());
+    for (uint64_t i = 0; i < queries.size(); ++i) {
+        const auto t0 = clock_type::now();
+        sum += query(queries[i]);
+        const auto t1 = clock_type::now();
+        latencies[i] = std::max(std::chrono::duration<double, std::nano>(t1 - t0).count() - timer_overhead_ns, 0.0);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min<uint64_t>(uint64_t(latencies.size() * p), latencies.size() - 1)];
+    };
+    stats.p50_ns = percentile(0.5);
+    stats.p99_ns = percentile(0.99);
+    stats.p999_ns = percentile(0.999);
+
+    g_sink = g_sink + sum;
+    return stats;
+}
+
+// Collects the results as JSON objects
+class json_writer {
+  public:
+    void add_query(const char* op, distribution dist, uint64_t num_trits, int trit, pattern p, uint64_t num_queries,
+                   const query_stats& s) {
+        std::ostringstream oss;
+        oss << "{\"kind\": \"query\", \"op\": \"" << op << "\", \"distribution\": \"" << to_string(dist)
+            << "\", \"num_trits\": " << num_trits << ", \"trit\": " << trit << ", \"pattern\": \"" << to_string(p)
+            << "\", \"num_queries\": " << num_queries << ", \"p50_ns\": " << s.p50_ns << ", \"p99_ns\": " << s.p99_ns
+            << ", \"p999_ns\": " << s.p999_ns << ", \"mean_ns\": " << s.mean_ns << ", \"mops\": " << s.mops << "}";
+        m_results.push_back(oss.str());
+    }
+    void add_bulk(const char* op, distribution dist, uint64_t num_trits, int trit, double seconds, uint64_t bytes) {
+        std::ostringstream oss;
+        oss << "{\"kind\": \"bulk\", \"op\": \"" << op << "\", \"distribution\": \"" << to_string(dist)
+            << "\", \"num_trits\": " << num_trits << ", \"trit\": " << trit << ", \"seconds\": " << seconds
+            << ", \"ns_per_trit\": " << seconds * 1e9 / num_trits << ", \"bytes\": " << bytes
+            << ", \"mb_per_s\": " << bytes / seconds / 1e6 << "}";
+        m_results.push_back(oss.str());
+    }
+
+    bool write(const std::string& path, const options& opts, double timer_overhead_ns) const {
+        std::ofstream ofs(path);
+        if (!ofs) {
+            return false;
+        }
+        ofs << "{\n  \"context\": {\"compiler\": \"" << __VERSION__ << "\", \"simd\": \"" << get_simd_name()
+            << "\", \"hardware_concurrency\": " << std::thread::hardware_concurrency()
+            << ", \"timer_overhead_ns\": " << timer_overhead_ns << ", \"num_queries\": " << opts.num_queries
+            << "},\n  \"results\": [\n";
+        for (uint64_t i = 0; i < m_results.size(); ++i) {
+            ofs << "    " << m_results[i] << (i + 1 < m_results.size() ? ",\n" : "\n");
+        }
+        ofs << "  ]\n}\n";
+        return bool(ofs);
+    }
+
+  private:
+    std::vector<std::string> m_results;
+
+    static const char* get_simd_name() {
+        return succinctrits::to_string(succinctrits::get_isa());
+    }
+};
+
+double seconds_since(clock_type::time_point tp) {
+    return std::chrono::duration<double>(clock_type::now() - tp).count();
+}
+
+template <uint8_t Trit>
+void run_trit(const succinctrits::trit_vector& tv, distribution dist, const options& opts, double timer_overhead_ns,
+              json_writer& json) {
+    const uint64_t num_trits = tv.get_num_trits();
+
+    auto beg = clock_type::now();
+    succinctrits::rs_support<Trit> tv_rs(&tv);
+    json.add_bulk("build_rs_support", dist, num_trits, Trit, seconds_since(beg), tv_rs.size_in_bytes());
+
+    {
+        std::ofstream ofs(opts.tmp_path, std::ios::binary);
+        beg = clock_type::now();
+        tv_rs.save(ofs);
+        ofs.flush();
+        json.add_bulk("save_rs_support", dist, num_trits, Trit, seconds_since(beg), tv_rs.size_in_bytes());
+    }
+    {
+        std::ifstream ifs(opts.tmp_path, std::ios::binary);
+        succinctrits::rs_support<Trit> loaded;
+        beg = clock_type::now();
+        loaded.load(ifs);
+        json.add_bulk("load_rs_support", dist, num_trits, Trit, seconds_since(beg), loaded.size_in_bytes());
+    }
+
+    for (pattern p : {pattern::random, pattern::sequential, pattern::clustered}) {
+        const auto positions = generate_queries(p, num_trits, opts.num_queries, 101 + uint64_t(p));
+        const auto rank_stats = measure(positions, timer_overhead_ns, [&](uint64_t i) { return tv_rs.rank(i); });
+        json.add_query("rank", dist, num_trits, Trit, p, positions.size(), rank_stats);
+
+        const auto ns = generate_queries(p, tv_rs.get_num_target_trits(), opts.num_queries, 201 + uint64_t(p));
+        const auto select_stats = measure(ns, timer_overhead_ns, [&](uint64_t n) { return tv_rs.select(n); });
+        json.add_query("select", dist, num_trits, Trit, p, ns.size(), select_stats);
+
+        std::cout << "  trit " << int(Trit) << ", " << to_string(p) << ": rank p50/p99/p99.9 = " << rank_stats.p50_ns
+                  << "/" << rank_stats.p99_ns << "/" << rank_stats.p999_ns << " ns, select p50/p99/p99.9 = "
+                  << select_stats.p50_ns << "/" << select_stats.p99_ns << "/" << select_stats.p999_ns << " ns"
+                  << std::endl;
+    }
+}
+
+void run(uint64_t num_trits, distribution dist, const options& opts, double timer_overhead_ns, json_writer& json) {
+    std::cout << "=== " << num_trits << " trits, " << to_string(dist) << " ===" << std::endl;
+
+    // Generated in chunks not to hold a byte per trit
+    static constexpr uint64_t CHUNK_SIZE = 1 << 20;
+    trit_generator gen(dist, 1000 + uint64_t(dist));
+    std::vector<uint8_t> chunk(CHUNK_SIZE);
+
+    auto beg = clock_type::now();
+    double gen_seconds = 0.0;
+    succinctrits::trit_vector::builder b;
+    b.reserve(num_trits);
+    for (uint64_t i = 0; i < num_trits; i += CHUNK_SIZE) {
+        const uint64_t size = std::min(num_trits - i, CHUNK_SIZE);
+        const auto gen_beg = clock_type::now();
+        gen.generate(chunk.data(), size);
+        gen_seconds += seconds_since(gen_beg);
+        b.append(chunk.data(), size);
+    }
+    succinctrits::trit_vector tv;
+    tv.build(&b);
+    json.add_bulk("build_trit_vector", dist, num_trits, -1, seconds_since(beg) - gen_seconds, tv.size_in_bytes());
+
+    {
+        std::ofstream ofs(opts.tmp_path, std::ios::binary);
+        beg = clock_type::now();
+        tv.save(ofs);
+        ofs.flush();
+        json.add_bulk("save_trit_vector", dist, num_trits, -1, seconds_since(beg), tv.size_in_bytes());
+    }
+    {
+        std::ifstream ifs(opts.tmp_path, std::ios::binary);
+        succinctrits::trit_vector loaded;
+        beg = clock_type::now();
+        loaded.load(ifs);
+        json.add_bulk("load_trit_vector", dist, num_trits, -1, seconds_since(beg), loaded.size_in_bytes());
+    }
+
+    for (pattern p : {pattern::random, pattern::sequential, pattern::clustered}) {
+        const auto positions = generate_queries(p, num_trits, opts.num_queries, 1 + uint64_t(p));
+        const auto stats = measure(positions, timer_overhead_ns, [&](uint64_t i) { return tv[i]; });
+        json.add_query("access", dist, num_trits, -1, p, positions.size(), stats);
+        std::cout << "  " << to_string(p) << ": access p50/p99/p99.9 = " << stats.p50_ns << "/" << stats.p99_ns << "/"
+                  << stats.p999_ns << " ns" << std::endl;
+    }
+
+    run_trit<0>(tv, dist, opts, timer_overhead_ns, json);
+    run_trit<1>(tv, dist, opts, timer_overhead_ns, json);
+    run_trit<2>(tv, dist, opts, timer_overhead_ns, json);
+}
+
+bool parse_options(int argc, char** argv, options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 == argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--min-trits") {
+            opts.min_trits = std::stoull(value);
+        } else if (arg == "--max-trits") {
+            opts.max_trits = std::stoull(value);
+        } else if (arg == "--queries") {
+            opts.num_queries = std::stoull(value);
+        } else if (arg == "--json") {
+            opts.json_path = value;
+        } else if (arg == "--tmp") {
+            opts.tmp_path = value;
+        } else {
+            return false;
+        }
+    }
+    return opts.min_trits != 0 && opts.min_trits <= opts.max_trits;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    options opts;
+    if (!parse_options(argc, argv, opts)) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--min-trits N] [--max-trits N] [--queries N] [--json PATH] [--tmp PATH]" << std::endl;
+        return 1;
+    }
+
+    const double timer_overhead_ns = get_timer_overhead_ns();
+    json_writer json;
+
+    for (uint64_t num_trits = opts.min_trits; num_trits <= opts.max_trits; num_trits *= 10) {
+        for (distribution dist : {distribution::uniform, distribution::skewed, distribution::runs}) {
+            run(num_trits, dist, opts, timer_overhead_ns, json);
+        }
+    }
+    std::remove(opts.tmp_path.c_str());
+
+    if (!json.write(opts.json_path, opts, timer_overhead_ns)) {
+        std::cerr << "failed to write " << opts.json_path << std::endl;
+        return 1;
+    }
+    std::cout << "# results are written to " << opts.json_path << std::endl;
+    return 0;
+}
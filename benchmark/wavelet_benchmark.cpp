@@ -0,0 +1,256 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <wavelet_matrix.hpp>
+
+static constexpr uint64_t NUM_QUERIES = 100'000;
+
+class timer {
+  public:
+    using hrc = std::chrono::high_resolution_clock;
+
+    timer() = default;
+
+    template <class Duration>
+    double get() const {
+        return std::chrono::duration_cast<Duration>(hrc::now() - tp_).count();
+    }
+
+  private:
+    hrc::time_point tp_ = hrc::now();
+};
+
+// Baseline: bit vector with a rank directory on every 512 bits, i.e., a cache line
+class bit_vector {
+  public:
+    explicit bit_vector(const std::vector<bool>& bits) : m_size(bits.size()) {
+        m_words.resize(bits.size() / 64 + 1, 0);
+        for (uint64_t i = 0; i < bits.size(); ++i) {
+            m_words[i / 64] |= uint64_t(bits[i]) << (i % 64);
+        }
+        uint64_t rank = 0;
+        for (uint64_t i = 0; i < m_words.size(); ++i) {
+            if (i % 8 == 0) {
+                m_blocks.push_back(rank);
+            }
+            rank += __builtin_popcountll(m_words[i]);
+        }
+        m_num_ones = rank;
+    }
+
+    bool get(uint64_t i) const {
+        return m_words[i / 64] >> (i % 64) & 1;
+    }
+    // Returns the number of 1s between positions 0 and i-1, for i <= size.
+    uint64_t rank1(uint64_t i) const {
+        uint64_t rank = m_blocks[i / 512];
+        for (uint64_t j = i / 512 * 8; j < i / 64; ++j) {
+            rank += __builtin_popcountll(m_words[j]);
+        }
+        if (i % 64 != 0) {
+            rank += __builtin_popcountll(m_words[i / 64] << (64 - i % 64));
+        }
+        return rank;
+    }
+    uint64_t get_num_ones() const {
+        return m_num_ones;
+    }
+    uint64_t size_in_bytes() const {
+        return m_words.size() * sizeof(uint64_t) + m_blocks.size() * sizeof(uint64_t);
+    }
+
+  private:
+    uint64_t m_size = 0;
+    uint64_t m_num_ones = 0;
+    std::vector<uint64_t> m_words;
+    std::vector<uint64_t> m_blocks;
+};
+
+// Baseline: binary wavelet matrix with ceil(log2(sigma)) levels of bit_vector
+class binary_wavelet_matrix {
+  public:
+    binary_wavelet_matrix(const std::vector<uint64_t>& values, uint64_t sigma) {
+        m_num_levels = 1;
+        while ((uint64_t(1) << m_num_levels) < sigma) {
+            ++m_num_levels;
+        }
+        std::vector<uint64_t> cur = values, next(values.size());
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const uint64_t shift = m_num_levels - level - 1;
+            std::vector<bool> bits(cur.size());
+            uint64_t num_zeros = 0;
+            for (uint64_t i = 0; i < cur.size(); ++i) {
+                bits[i] = cur[i] >> shift & 1;
+                num_zeros += !bits[i];
+            }
+            uint64_t pos[2] = {0, num_zeros};
+            for (uint64_t i = 0; i < cur.size(); ++i) {
+                next[pos[bits[i]]++] = cur[i];
+            }
+            cur.swap(next);
+            m_levels.emplace_back(bits);
+            m_num_zeros.push_back(num_zeros);
+        }
+    }
+
+    uint64_t access(uint64_t i) const {
+        uint64_t value = 0;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const bool b = m_levels[level].get(i);
+            i = b ? m_num_zeros[level] + m_levels[level].rank1(i) : i - m_levels[level].rank1(i);
+            value = value << 1 | b;
+        }
+        return value;
+    }
+    uint64_t rank(uint64_t c, uint64_t i) const {
+        uint64_t beg = 0, end = i;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const bool b = c >> (m_num_levels - level - 1) & 1;
+            beg = next_pos(level, b, beg);
+            end = next_pos(level, b, end);
+        }
+        return end - beg;
+    }
+    uint64_t quantile(uint64_t beg, uint64_t end, uint64_t k) const {
+        uint64_t value = 0;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const uint64_t beg_ones = m_levels[level].rank1(beg), end_ones = m_levels[level].rank1(end);
+            const uint64_t zeros = (end - end_ones) - (beg - beg_ones);
+            if (k < zeros) {
+                beg = beg - beg_ones;
+                end = end - end_ones;
+                value <<= 1;
+            } else {
+                k -= zeros;
+                beg = m_num_zeros[level] + beg_ones;
+                end = m_num_zeros[level] + end_ones;
+                value = value << 1 | 1;
+            }
+        }
+        return value;
+    }
+    uint64_t get_num_levels() const {
+        return m_num_levels;
+    }
+    uint64_t size_in_bytes() const {
+        uint64_t bytes = 0;
+        for (const auto& level : m_levels) {
+            bytes += level.size_in_bytes();
+        }
+        return bytes;
+    }
+
+  private:
+    uint64_t m_num_levels = 0;
+    std::vector<bit_vector> m_levels;
+    std::vector<uint64_t> m_num_zeros;
+
+    uint64_t next_pos(uint64_t level, bool b, uint64_t i) const {
+        const uint64_t ones = m_levels[level].rank1(i);
+        return b ? m_num_zeros[level] + ones : i - ones;
+    }
+};
+
+template <class WaveletMatrix>
+void benchmark(const WaveletMatrix& wm, const std::vector<uint64_t>& values, uint64_t sigma, const char* label) {
+    std::default_random_engine engine(31);
+    std::uniform_int_distribution<uint64_t> pos_dist(0, values.size() - 1);
+    std::vector<uint64_t> positions(NUM_QUERIES), ranges(NUM_QUERIES);
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        positions[i] = pos_dist(engine);
+        ranges[i] = std::uniform_int_distribution<uint64_t>(1, values.size() - positions[i])(engine);
+    }
+
+    uint64_t sum = 0;
+    timer t1;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += wm.access(positions[i]);
+    }
+    const double access_time = t1.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+
+    timer t2;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += wm.rank(values[positions[i]], positions[i]);
+    }
+    const double rank_time = t2.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+
+    timer t3;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += wm.quantile(positions[i], positions[i] + ranges[i], ranges[i] / 2);
+    }
+    const double quantile_time = t3.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+
+    if (sum == 0) {  // to avoid opt.
+        std::cerr << "critical error" << std::endl;
+        exit(1);
+    }
+
+    std::cout << "# " << label << ": " << wm.get_num_levels() << " levels, "
+              << wm.size_in_bytes() * 8.0 / values.size() << " bits/value" << std::endl;
+    std::cout << "#   access time:   " << access_time << " ns/op" << std::endl;
+    std::cout << "#   rank time:     " << rank_time << " ns/op" << std::endl;
+    std::cout << "#   quantile time: " << quantile_time << " ns/op" << std::endl;
+}
+
+// Measures the queries supported only by the ternary one
+void benchmark_ternary_only(const succinctrits::wavelet_matrix& wm, const std::vector<uint64_t>& values,
+                            uint64_t sigma) {
+    std::default_random_engine engine(37);
+    std::uniform_int_distribution<uint64_t> pos_dist(0, values.size() - 1);
+    std::uniform_int_distribution<uint64_t> value_dist(0, sigma - 1);
+
+    std::vector<uint64_t> cs(NUM_QUERIES), ns(NUM_QUERIES);
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        cs[i] = values[pos_dist(engine)];
+        ns[i] = std::uniform_int_distribution<uint64_t>(0, wm.rank(cs[i], values.size()) - 1)(engine);
+    }
+
+    uint64_t sum = 0;
+    timer t1;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        sum += wm.select(cs[i], ns[i]);
+    }
+    const double select_time = t1.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+
+    timer t2;
+    for (uint64_t i = 0; i < NUM_QUERIES; ++i) {
+        const uint64_t beg = pos_dist(engine) / 2;
+        const uint64_t lo = value_dist(engine) / 2;
+        sum += wm.range_count(beg, beg + values.size() / 2, lo, lo + sigma / 4);
+    }
+    const double range_count_time = t2.get<std::chrono::nanoseconds>() / NUM_QUERIES;
+
+    if (sum == 0) {  // to avoid opt.
+        std::cerr << "critical error" << std::endl;
+        exit(1);
+    }
+    std::cout << "#   select time:   " << select_time << " ns/op" << std::endl;
+    std::cout << "#   range_count time: " << range_count_time << " ns/op" << std::endl;
+}
+
+int main() {
+    const uint64_t num = 10'000'000;
+
+    for (uint64_t sigma : {uint64_t(256), uint64_t(65536), uint64_t(1) << 24}) {
+        std::cout << "=== Benchmark for " << num << " values with sigma = " << sigma << " ===" << std::endl;
+
+        std::default_random_engine engine(41);
+        std::uniform_int_distribution<uint64_t> dist(0, sigma - 1);
+        std::vector<uint64_t> values(num);
+        for (uint64_t i = 0; i < num; ++i) {
+            values[i] = dist(engine);
+        }
+
+        {
+            succinctrits::wavelet_matrix wm(values.begin(), num, sigma);
+            benchmark(wm, values, sigma, "ternary");
+            benchmark_ternary_only(wm, values, sigma);
+        }
+        {
+            binary_wavelet_matrix wm(values, sigma);
+            benchmark(wm, values, sigma, "binary");
+        }
+    }
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <memory>
+
+#include "trit_vector.hpp"
+#include "tryte_lut.hpp"
+
+namespace succinctrits {
+
+// Append-only trit vector with Rank/Select support for all the three trits, for streaming data.
+//
+// The trits are stored in segments of one large block each, which are never moved, and the
+// directories are extended each time a small block fills up. Then the trits appended so far are
+// committed, i.e., become visible to queries. A single writer can append trits while any number of
+// readers query the committed prefix concurrently.
+class appendable_trit_vector {
+  public:
+    static constexpr uint64_t TRITS_PER_LB = 65550;
+    static constexpr uint64_t TRITS_PER_SB = 50;
+
+  private:
+    static constexpr uint64_t TRITS_PER_BYTE = trit_vector::TRITS_PER_BYTE;
+    static constexpr uint64_t TRYTES_PER_LB = TRITS_PER_LB / TRITS_PER_BYTE;  // 13110 trytes
+    static constexpr uint64_t TRYTES_PER_SB = TRITS_PER_SB / TRITS_PER_BYTE;  // 10 trytes
+    static constexpr uint64_t SB_PER_LB = TRITS_PER_LB / TRITS_PER_SB;  // 1311
+
+    // The segments are reached through a two-level table of fixed size, so that they can be added
+    // without moving anything readers may access. Up to 2^20 segments (about 6.9 * 10^10 trits).
+    static constexpr uint64_t SEGMENTS_PER_TABLE = 1024;
+    static constexpr uint64_t NUM_TABLES = 1024;
+
+  public:
+    appendable_trit_vector() {
+        add_segment(0);
+    }
+
+    appendable_trit_vector(const appendable_trit_vector&) = delete;
+    appendable_trit_vector& operator=(const appendable_trit_vector&) = delete;
+
+    // Appends a trit. Only a single thread can call it at a time.
+    void push_back(uint8_t t) {
+        assert(t < 3);
+
+        static constexpr uint8_t POW3[TRITS_PER_BYTE] = {1, 3, 9, 27, 81};
+
+        segment* seg = get_segment(m_num_trits / TRITS_PER_LB);
+        const uint64_t k = m_num_trits % TRITS_PER_LB;
+        seg->trytes[k / TRITS_PER_BYTE] += uint8_t(t * POW3[k % TRITS_PER_BYTE]);
+
+        ++m_ranks[t];
+        ++m_num_trits;
+        if (m_num_trits % TRITS_PER_SB == 0) {
+            commit();
+        }
+    }
+
+    // Appends trits[0..num_trits). Only a single thread can call it at a time.
+    // Whole small blocks are packed in bulk.
+    void append(const uint8_t* trits, uint64_t num_trits) {
+        uint64_t i = 0;
+        for (; i < num_trits && m_num_trits % TRITS_PER_SB != 0; ++i) {
+            push_back(trits[i]);
+        }
+        for (; i + TRITS_PER_SB <= num_trits; i += TRITS_PER_SB) {
+            segment* seg = get_segment(m_num_trits / TRITS_PER_LB);
+            uint8_t* trytes = seg->trytes + m_num_trits % TRITS_PER_LB / TRITS_PER_BYTE;
+            detail::pack_trytes<false>(trits + i, TRYTES_PER_SB, trytes);
+
+            uint16_t cnt = 0;
+            for (uint64_t j = 0; j < TRYTES_PER_SB; ++j) {
+                cnt += get_lut(4, trytes[j]);
+            }
+            m_ranks[0] += cnt & 0xFF;
+            m_ranks[1] += cnt >> 8;
+            m_ranks[2] += TRITS_PER_SB - (cnt & 0xFF) - (cnt >> 8);
+            m_num_trits += TRITS_PER_SB;
+            commit();
+        }
+        for (; i < num_trits; ++i) {
+            push_back(trits[i]);
+        }
+    }
+
+    // Returns the number of trits appended, including the ones not committed yet.
+    // Only the writer can call it.
+    uint64_t get_num_appended_trits() const {
+        return m_num_trits;
+    }
+
+    // The following functions can be called concurrently with the writer.
+
+    // Returns the number of committed trits, which is a multiple of TRITS_PER_SB.
+    uint64_t get_num_trits() const {
+        return m_num_committed.load(std::memory_order_acquire);
+    }
+
+    uint8_t get(uint64_t i) const {
+        assert(i < get_num_trits());
+        const uint8_t tryte = get_segment(i / TRITS_PER_LB)->trytes[i % TRITS_PER_LB / TRITS_PER_BYTE];
+        return uint8_t(detail::tryte_luts<>::EXPAND.table[tryte] >> (i % TRITS_PER_BYTE * 8));
+    }
+    uint8_t operator[](uint64_t i) const {
+        return get(i);
+    }
+
+    // Returns the numbers of occurrences of 0s, 1s and 2s between positions 0 and i-1,
+    // for i <= get_num_trits().
+    std::array<uint64_t, 3> rank_all(const uint64_t i) const {
+        assert(i <= get_num_trits());
+
+        const segment* seg = get_segment(i / TRITS_PER_LB);
+        const uint64_t k = i % TRITS_PER_LB;
+        const uint64_t sb_pos = k / TRITS_PER_SB;
+        uint64_t rank_0 = seg->large_block[0] + seg->small_blocks[sb_pos * 2];
+        uint64_t rank_1 = seg->large_block[1] + seg->small_blocks[sb_pos * 2 + 1];
+
+        const uint64_t tryte_pos = k / TRITS_PER_BYTE;
+        uint16_t cnt = 0;
+        for (uint64_t j = sb_pos * TRYTES_PER_SB; j < tryte_pos; ++j) {
+            cnt += get_lut(4, seg->trytes[j]);
+        }
+        if (k % TRITS_PER_BYTE != 0) {
+            cnt += get_lut(k % TRITS_PER_BYTE - 1, seg->trytes[tryte_pos]);
+        }
+
+        rank_0 += cnt & 0xFF;
+        rank_1 += cnt >> 8;
+        return {{rank_0, rank_1, i - rank_0 - rank_1}};
+    }
+
+    template <uint8_t Trit>
+    uint64_t rank(const uint64_t i) const {
+        static_assert(Trit < 3, "");
+        return rank_all(i)[Trit];
+    }
+
+    // Returns the position of the (n+1)-th occurrence of Trit, for n < get_num_target_trits<Trit>().
+    template <uint8_t Trit>
+    uint64_t select(uint64_t n) const {
+        static_assert(Trit < 3, "");
+        const uint64_t num_trits = get_num_trits();
+        assert(n < rank<Trit>(num_trits));
+
+        // (1) Search on Large Blocks (i.e., segments)
+        uint64_t left = 0;
+        uint64_t right = (num_trits - 1) / TRITS_PER_LB + 1;
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < get_lb_count<Trit>(center)) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+        const uint64_t seg_pos = left;
+        const segment* seg = get_segment(seg_pos);
+        n = n - get_lb_count<Trit>(seg_pos);
+
+        // (2) Search on Small Blocks
+        left = 0;
+        right = std::min<uint64_t>((num_trits - seg_pos * TRITS_PER_LB) / TRITS_PER_SB, uint64_t(SB_PER_LB));
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < get_sb_count<Trit>(seg, center)) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+
+        // (3) Search on the remaining trytes
+        n = n - get_sb_count<Trit>(seg, left) + 1;
+        uint64_t i = left * TRYTES_PER_SB;
+        for (;; ++i) {
+            const uint64_t cnt = get_tryte_count<Trit>(4, seg->trytes[i]);
+            if (n <= cnt) {
+                break;
+            }
+            n = n - cnt;
+        }
+
+        const uint8_t tryte = seg->trytes[i];
+        return seg_pos * TRITS_PER_LB + i * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][n - 1][tryte];
+    }
+
+    // Returns the number of Trit in the committed trits.
+    template <uint8_t Trit>
+    uint64_t get_num_target_trits() const {
+        return rank<Trit>(get_num_trits());
+    }
+
+  private:
+    struct segment {
+        uint64_t large_block[2];  // counts of 0s and 1s before the segment
+        uint16_t small_blocks[SB_PER_LB * 2];  // counts of 0s and 1s, interleaved
+        uint8_t trytes[TRYTES_PER_LB];
+    };
+
+    // Written only by the writer before m_num_committed is released
+    std::unique_ptr<std::unique_ptr<segment>[]> m_tables[NUM_TABLES];
+    std::atomic<uint64_t> m_num_committed{0};
+
+    // Used only by the writer
+    uint64_t m_num_trits = 0;
+    uint64_t m_ranks[3] = {0, 0, 0};
+
+    segment* get_segment(uint64_t seg_pos) const {
+        assert(seg_pos < NUM_TABLES * SEGMENTS_PER_TABLE);
+        return m_tables[seg_pos / SEGMENTS_PER_TABLE][seg_pos % SEGMENTS_PER_TABLE].get();
+    }
+
+    void add_segment(uint64_t seg_pos) {
+        assert(seg_pos < NUM_TABLES * SEGMENTS_PER_TABLE);
+        auto& table = m_tables[seg_pos / SEGMENTS_PER_TABLE];
+        if (!table) {
+            table.reset(new std::unique_ptr<segment>[SEGMENTS_PER_TABLE]);
+        }
+        segment* seg = new segment();  // zero-initialized
+        seg->large_block[0] = m_ranks[0];
+        seg->large_block[1] = m_ranks[1];
+        table[seg_pos % SEGMENTS_PER_TABLE].reset(seg);
+    }
+
+    // Writes the small block starting at m_num_trits and publishes the trits before it.
+    void commit() {
+        assert(m_num_trits % TRITS_PER_SB == 0);
+
+        const uint64_t seg_pos = m_num_trits / TRITS_PER_LB;
+        if (m_num_trits % TRITS_PER_LB == 0) {
+            add_segment(seg_pos);
+        }
+        segment* seg = get_segment(seg_pos);
+        const uint64_t sb_pos = m_num_trits % TRITS_PER_LB / TRITS_PER_SB;
+        assert(m_ranks[0] - seg->large_block[0] <= UINT16_MAX);
+        assert(m_ranks[1] - seg->large_block[1] <= UINT16_MAX);
+        seg->small_blocks[sb_pos * 2] = uint16_t(m_ranks[0] - seg->large_block[0]);
+        seg->small_blocks[sb_pos * 2 + 1] = uint16_t(m_ranks[1] - seg->large_block[1]);
+
+        m_num_committed.store(m_num_trits, std::memory_order_release);
+    }
+
+    static uint16_t get_lut(uint64_t k, uint8_t tryte) {
+        return detail::tryte_luts<>::FUSED.table[k][tryte];
+    }
+    template <uint8_t Trit>
+    uint64_t get_lb_count(uint64_t seg_pos) const {
+        const segment* seg = get_segment(seg_pos);
+        if (Trit == 2) {
+            return seg_pos * TRITS_PER_LB - seg->large_block[0] - seg->large_block[1];
+        }
+        return seg->large_block[Trit];
+    }
+    template <uint8_t Trit>
+    static uint64_t get_sb_count(const segment* seg, uint64_t sb_pos) {
+        if (Trit == 2) {
+            return sb_pos * TRITS_PER_SB - seg->small_blocks[sb_pos * 2] - seg->small_blocks[sb_pos * 2 + 1];
+        }
+        return seg->small_blocks[sb_pos * 2 + Trit];
+    }
+    // Returns the number of Trit in the first k+1 trits of the tryte.
+    template <uint8_t Trit>
+    static uint64_t get_tryte_count(uint64_t k, uint8_t tryte) {
+        const uint16_t cnt = get_lut(k, tryte);
+        if (Trit == 0) {
+            return cnt & 0xFF;
+        } else if (Trit == 1) {
+            return cnt >> 8;
+        }
+        return k + 1 - (cnt & 0xFF) - (cnt >> 8);
+    }
+};
+
+}  // namespace succinctrits
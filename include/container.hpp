@@ -0,0 +1,408 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fused_rs_support.hpp"
+#include "mmap_file.hpp"
+#include "rs_support.hpp"
+#include "trit_vector.hpp"
+
+namespace succinctrits {
+
+// Self-describing file holding a trit_vector and any subset of its Rank/Select indexes.
+//
+// Layout (all integers in the native byte order, which is recorded by ENDIAN_MARKER):
+//   header        : container_header (64 bytes)
+//   section table : container_section_entry * num_sections
+//   payloads      : each is what save() of the data structure writes, starting at a 64-byte boundary
+//
+// The loader checks the header and the block parameters of the sections up front, and reads only
+// the sections requested. Since the payloads are aligned, they can also be mapped in place.
+
+enum class section_type : uint32_t {
+    TRIT_VECTOR = 1,
+    RS_SUPPORT_0 = 2,
+    RS_SUPPORT_1 = 3,
+    RS_SUPPORT_2 = 4,
+    FUSED_RS_SUPPORT = 5,
+};
+
+struct container_header {
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t ENDIAN_MARKER = 0x01020304;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_marker;
+    uint64_t num_sections;
+    uint64_t reserved[5];
+};
+static_assert(sizeof(container_header) == 64, "");
+
+namespace detail {
+
+inline const char* container_magic() {
+    return "SUCCTRIT";  // 8 bytes without the terminator
+}
+
+}  // namespace detail
+
+struct container_section_entry {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t params;  // block parameters of the data structure
+    uint64_t offset;  // in bytes from the beginning of the file
+    uint64_t size;  // in bytes
+    uint64_t checksum;
+};
+static_assert(sizeof(container_section_entry) == 40, "");
+
+// Section type and block parameters of each data structure
+template <class T>
+struct container_section;
+
+template <>
+struct container_section<trit_vector> {
+    static constexpr section_type type = section_type::TRIT_VECTOR;
+    static constexpr uint64_t params = trit_vector::TRITS_PER_BYTE;
+};
+
+// The width of the counters is put in bits 16-31 unless it is the default 16 bits, so that the files of
+// the default parameters are unchanged.
+template <uint8_t Trit, uint64_t TritsPerLB, uint64_t TritsPerSB, class Counter>
+struct container_section<rs_support<Trit, TritsPerLB, TritsPerSB, Counter>> {
+    static constexpr section_type type = section_type(uint32_t(section_type::RS_SUPPORT_0) + Trit);
+    static constexpr uint64_t params =
+        TritsPerLB << 32 | (sizeof(Counter) == sizeof(uint16_t) ? 0 : sizeof(Counter) * 8) << 16 | TritsPerSB;
+};
+
+template <>
+struct container_section<fused_rs_support> {
+    static constexpr section_type type = section_type::FUSED_RS_SUPPORT;
+    static constexpr uint64_t params = fused_rs_support::TRITS_PER_LB << 32 | fused_rs_support::TRITS_PER_SB;
+};
+
+namespace detail {
+
+// Fast 64-bit checksum processing eight bytes at once. The result does not depend on how the
+// input is split into update() calls.
+class checksum64 {
+  public:
+    void update(const void* data, uint64_t size) {
+        const uint8_t* ptr = static_cast<const uint8_t*>(data);
+        m_size += size;
+        while (size != 0 && m_buf_size != 0) {
+            m_buf[m_buf_size++] = *ptr++;
+            --size;
+            if (m_buf_size == 8) {
+                mix(load_word(m_buf));
+                m_buf_size = 0;
+            }
+        }
+        for (; size >= 8; size -= 8, ptr += 8) {
+            mix(load_word(ptr));
+        }
+        for (; size != 0; --size) {
+            m_buf[m_buf_size++] = *ptr++;
+        }
+    }
+    uint64_t finish() const {
+        uint64_t h = m_hash;
+        if (m_buf_size != 0) {
+            uint8_t buf[8] = {};
+            std::memcpy(buf, m_buf, m_buf_size);
+            h = (h ^ load_word(buf)) * PRIME;
+            h ^= h >> 29;
+        }
+        h ^= m_size;
+        h *= PRIME;
+        return h ^ (h >> 32);
+    }
+
+  private:
+    static constexpr uint64_t PRIME = 0x9E3779B97F4A7C15ULL;
+
+    uint64_t m_hash = 0;
+    uint64_t m_size = 0;
+    uint8_t m_buf[8] = {};
+    uint64_t m_buf_size = 0;
+
+    static uint64_t load_word(const uint8_t* ptr) {
+        uint64_t w = 0;
+        std::memcpy(&w, ptr, sizeof(uint64_t));
+        return w;
+    }
+    void mix(uint64_t w) {
+        m_hash = (m_hash ^ w) * PRIME;
+        m_hash ^= m_hash >> 29;
+    }
+};
+
+// Output stream buffer forwarding to another one while counting and hashing the bytes
+class checksum_streambuf : public std::streambuf {
+  public:
+    explicit checksum_streambuf(std::streambuf* sink) : m_sink(sink) {}
+
+    uint64_t get_size() const {
+        return m_size;
+    }
+    uint64_t get_checksum() const {
+        return m_checksum.finish();
+    }
+
+  protected:
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        m_checksum.update(s, uint64_t(n));
+        m_size += uint64_t(n);
+        return m_sink->sputn(s, n);
+    }
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        const char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+  private:
+    std::streambuf* m_sink;
+    checksum64 m_checksum;
+    uint64_t m_size = 0;
+};
+
+// Input stream buffer reading a memory region
+class memory_streambuf : public std::streambuf {
+  public:
+    memory_streambuf(const uint8_t* data, uint64_t size) {
+        char* beg = const_cast<char*>(reinterpret_cast<const char*>(data));
+        setg(beg, beg, beg + size);
+    }
+};
+
+}  // namespace detail
+
+class container_writer {
+  public:
+    static constexpr uint64_t ALIGNMENT = 64;
+
+    container_writer() = default;
+
+    // Registers the data structure to be written. It must be alive until save().
+    template <class T>
+    container_writer& add(const T& obj) {
+        const uint32_t type = uint32_t(container_section<T>::type);
+        for (const auto& section : m_sections) {
+            assert(section.entry.type != type);  // each data structure can be added only once
+            (void)section;
+        }
+        section s;
+        s.entry = container_section_entry{};
+        s.entry.type = type;
+        s.entry.params = container_section<T>::params;
+        s.save = [&obj](std::ostream& os) { obj.save(os); };
+        m_sections.push_back(std::move(s));
+        return *this;
+    }
+
+    void save(const char* path) {
+        std::ofstream ofs(path, std::ios::binary);
+        if (!ofs) {
+            throw std::runtime_error(std::string("failed to open ") + path);
+        }
+        save(ofs);
+        if (!ofs) {
+            throw std::runtime_error(std::string("failed to write ") + path);
+        }
+    }
+
+    // The stream must be seekable.
+    void save(std::ostream& os) {
+        const std::streamoff beg = os.tellp();
+
+        container_header header{};
+        std::memcpy(header.magic, detail::container_magic(), sizeof(header.magic));
+        header.version = container_header::VERSION;
+        header.endian_marker = container_header::ENDIAN_MARKER;
+        header.num_sections = m_sections.size();
+
+        // The header and table are written again after the payloads.
+        write_header(os, header);
+
+        uint64_t pos = sizeof(container_header) + sizeof(container_section_entry) * m_sections.size();
+        for (auto& section : m_sections) {
+            static const char zeros[ALIGNMENT] = {};
+            const uint64_t padding = (ALIGNMENT - pos % ALIGNMENT) % ALIGNMENT;
+            os.write(zeros, padding);
+            pos += padding;
+
+            detail::checksum_streambuf buf(os.rdbuf());
+            std::ostream section_os(&buf);
+            section.save(section_os);
+
+            section.entry.offset = pos;
+            section.entry.size = buf.get_size();
+            section.entry.checksum = buf.get_checksum();
+            pos += section.entry.size;
+        }
+
+        os.seekp(beg);
+        write_header(os, header);
+        os.seekp(beg + std::streamoff(pos));
+    }
+
+  private:
+    struct section {
+        container_section_entry entry;
+        std::function<void(std::ostream&)> save;
+    };
+    std::vector<section> m_sections;
+
+    void write_header(std::ostream& os, const container_header& header) const {
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& section : m_sections) {
+            os.write(reinterpret_cast<const char*>(&section.entry), sizeof(section.entry));
+        }
+    }
+};
+
+// Reader of a container file, which is memory-mapped. Sections can be either loaded (copied) into
+// data structures or mapped in place; in the latter case, the reader must outlive them.
+class container_reader {
+  public:
+    container_reader() = default;
+
+    explicit container_reader(const char* path) {
+        open(path);
+    }
+
+    // Throws std::runtime_error if the file is not a compatible container.
+    void open(const char* path) {
+        m_file.open(path);
+        m_entries.clear();
+
+        container_header header;
+        if (m_file.size() < sizeof(header)) {
+            throw std::runtime_error(std::string("too small container ") + path);
+        }
+        std::memcpy(&header, m_file.data(), sizeof(header));
+
+        if (std::memcmp(header.magic, detail::container_magic(), sizeof(header.magic)) != 0) {
+            throw std::runtime_error(std::string("not a container ") + path);
+        }
+        if (header.endian_marker != container_header::ENDIAN_MARKER) {
+            throw std::runtime_error(std::string("incompatible byte order of ") + path);
+        }
+        if (header.version != container_header::VERSION) {
+            throw std::runtime_error(std::string("unsupported version ") + std::to_string(header.version) +
+                                     " of " + path);
+        }
+
+        // Compared by division and subtraction so that a broken header cannot overflow the bounds.
+        if ((m_file.size() - sizeof(header)) / sizeof(container_section_entry) < header.num_sections) {
+            throw std::runtime_error(std::string("broken section table of ") + path);
+        }
+        m_entries.resize(header.num_sections);
+        std::memcpy(m_entries.data(), m_file.data() + sizeof(header),
+                    sizeof(container_section_entry) * header.num_sections);
+
+        for (const auto& entry : m_entries) {
+            if (m_file.size() < entry.offset || m_file.size() - entry.offset < entry.size ||
+                entry.offset % container_writer::ALIGNMENT != 0) {
+                throw std::runtime_error(std::string("broken section in ") + path);
+            }
+        }
+    }
+
+    template <class T>
+    bool contains() const {
+        return find_entry(uint32_t(container_section<T>::type)) != nullptr;
+    }
+
+    // Throws std::runtime_error if the section is missing, has different block parameters or is broken
+    // (e.g., an array runs past the end of the section).
+    template <class T>
+    void load(T* obj) const {
+        const container_section_entry& entry = get_entry<T>();
+        detail::memory_streambuf buf(m_file.data() + entry.offset, entry.size);
+        std::istream is(&buf);
+        obj->load(is);
+        if (!is) {
+            throw std::runtime_error("broken section type " + std::to_string(entry.type));
+        }
+    }
+    // Loads a Rank/Select index and attaches it to vec.
+    template <class T>
+    void load(T* obj, const trit_vector* vec) const {
+        load(obj);
+        obj->set_vector(vec);
+    }
+
+    // Throws std::runtime_error in the same cases as load().
+    template <class T>
+    void map(T* obj) const {
+        const container_section_entry& entry = get_entry<T>();
+        const uint8_t* beg = m_file.data() + entry.offset;
+        obj->map(beg, beg + entry.size);
+    }
+    // Maps a Rank/Select index and attaches it to vec.
+    template <class T>
+    void map(T* obj, const trit_vector* vec) const {
+        map(obj);
+        obj->set_vector(vec);
+    }
+
+    // Returns true if the checksum of the section matches.
+    template <class T>
+    bool verify() const {
+        return verify(get_entry<T>());
+    }
+    // Returns true if the checksums of all the sections match.
+    bool verify() const {
+        for (const auto& entry : m_entries) {
+            if (!verify(entry)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    mmap_file m_file;
+    std::vector<container_section_entry> m_entries;
+
+    const container_section_entry* find_entry(uint32_t type) const {
+        for (const auto& entry : m_entries) {
+            if (entry.type == type) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+    template <class T>
+    const container_section_entry& get_entry() const {
+        const uint32_t type = uint32_t(container_section<T>::type);
+        const container_section_entry* entry = find_entry(type);
+        if (entry == nullptr) {
+            throw std::runtime_error("missing section type " + std::to_string(type));
+        }
+        if (entry->params != container_section<T>::params) {
+            throw std::runtime_error("incompatible block parameters of section type " + std::to_string(type));
+        }
+        return *entry;
+    }
+    bool verify(const container_section_entry& entry) const {
+        detail::checksum64 checksum;
+        checksum.update(m_file.data() + entry.offset, entry.size);
+        return checksum.finish() == entry.checksum;
+    }
+};
+
+}  // namespace succinctrits
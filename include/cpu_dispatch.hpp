@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+
+// The SIMD kernels are compiled for every ISA with target attributes, independently of -march, and
+// the best one for the running CPU is chosen at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SUCCINCTRITS_USE_SIMD
+#define SUCCINCTRITS_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define SUCCINCTRITS_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt")))
+#define SUCCINCTRITS_TARGET_AVX512BW __attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi,bmi2,popcnt")))
+#endif
+
+namespace succinctrits {
+
+// Instruction sets of the kernel variants, from the slowest
+enum class isa : int { scalar, sse42, avx2, avx512bw };
+
+inline const char* to_string(isa x) {
+    switch (x) {
+        case isa::scalar:
+            return "scalar";
+        case isa::sse42:
+            return "SSE4.2";
+        case isa::avx2:
+            return "AVX2";
+        case isa::avx512bw:
+            return "AVX-512BW";
+    }
+    return "";
+}
+
+// Returns true if the running CPU supports x.
+inline bool is_supported(isa x) {
+#ifdef SUCCINCTRITS_USE_SIMD
+    __builtin_cpu_init();
+    switch (x) {
+        case isa::scalar:
+            return true;
+        case isa::sse42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case isa::avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+        case isa::avx512bw:
+            return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+                   __builtin_cpu_supports("bmi2");
+    }
+    return false;
+#else
+    return x == isa::scalar;
+#endif
+}
+
+// Returns the best ISA for the running CPU, or the one named by the environment variable
+// SUCCINCTRITS_ISA (scalar, sse42, avx2 or avx512bw) if it is supported.
+inline isa detect_isa() {
+    const isa all[] = {isa::scalar, isa::sse42, isa::avx2, isa::avx512bw};
+    const char* names[] = {"scalar", "sse42", "avx2", "avx512bw"};
+
+    const char* env = std::getenv("SUCCINCTRITS_ISA");
+    for (int i = 0; env != nullptr && i < 4; ++i) {
+        if (std::strcmp(env, names[i]) == 0 && is_supported(all[i])) {
+            return all[i];
+        }
+    }
+    isa best = isa::scalar;
+    for (isa x : all) {
+        if (is_supported(x)) {
+            best = x;
+        }
+    }
+    return best;
+}
+
+}  // namespace succinctrits
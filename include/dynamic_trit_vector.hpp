@@ -0,0 +1,298 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <vector>
+
+#include "trit_vector.hpp"
+#include "tryte_lut.hpp"
+
+namespace succinctrits {
+
+// Trit vector supporting point updates and appends, with Rank/Select for all the three trits.
+//
+// As in fused_rs_support, only the counts of 0s and 1s are kept, but in Fenwick trees instead of
+// prefix sums: a tree of 64-bit counters over large blocks, and a tree of 16-bit counters over the
+// small blocks in each large block. Then set(), push_back(), rank and select take O(log n) time.
+// Insertion and deletion are not supported.
+class dynamic_trit_vector {
+  public:
+    static constexpr uint64_t TRITS_PER_LB = 65550;
+    static constexpr uint64_t TRITS_PER_SB = 50;
+
+  private:
+    static constexpr uint64_t TRITS_PER_BYTE = trit_vector::TRITS_PER_BYTE;
+    static constexpr uint64_t TRYTES_PER_LB = TRITS_PER_LB / TRITS_PER_BYTE;  // 13110 trytes
+    static constexpr uint64_t TRYTES_PER_SB = TRITS_PER_SB / TRITS_PER_BYTE;  // 10 trytes
+    static constexpr uint64_t SB_PER_LB = TRITS_PER_LB / TRITS_PER_SB;  // 1311
+
+    // A node of the small block tree covers at most 1024 small blocks (51200 trits), so that the
+    // counts fit in 16 bits.
+    static_assert(1024 * TRITS_PER_SB <= UINT16_MAX && SB_PER_LB < 2048, "");
+
+  public:
+    dynamic_trit_vector() = default;
+
+    explicit dynamic_trit_vector(const trit_vector& vec) {
+        build(vec);
+    }
+
+    // Copies the trits of vec in O(n) time.
+    void build(const trit_vector& vec) {
+        m_num_trits = vec.get_num_trits();
+        m_trytes.assign(vec.m_trytes.begin(), vec.m_trytes.end());
+
+        const uint64_t num_lbs = (m_num_trits + TRITS_PER_LB - 1) / TRITS_PER_LB;
+        m_lb_tree.assign((num_lbs + 1) * 2, 0);
+        m_sb_tree.assign(num_lbs * SB_PER_LB * 2, 0);
+
+        // Counts of each block, which are turned into the trees in place.
+        for (uint64_t i = 0; i < m_trytes.size(); ++i) {
+            const uint16_t cnt = get_lut(4, m_trytes[i]);
+            const uint64_t lb_pos = i / TRYTES_PER_LB;
+            const uint64_t sb_pos = i / TRYTES_PER_SB;  // absolute
+            m_lb_tree[(lb_pos + 1) * 2] += cnt & 0xFF;
+            m_lb_tree[(lb_pos + 1) * 2 + 1] += cnt >> 8;
+            m_sb_tree[sb_pos * 2] += cnt & 0xFF;
+            m_sb_tree[sb_pos * 2 + 1] += cnt >> 8;
+        }
+        if (m_num_trits % TRITS_PER_BYTE != 0) {
+            // The unused trits in the last tryte are filled with 0s
+            const uint64_t padding = TRITS_PER_BYTE - m_num_trits % TRITS_PER_BYTE;
+            m_lb_tree[num_lbs * 2] -= padding;
+            m_sb_tree[(m_trytes.size() - 1) / TRYTES_PER_SB * 2] -= uint16_t(padding);
+        }
+
+        for (uint64_t j = 1; j <= num_lbs; ++j) {
+            const uint64_t parent = j + lowbit(j);
+            if (parent <= num_lbs) {
+                m_lb_tree[parent * 2] += m_lb_tree[j * 2];
+                m_lb_tree[parent * 2 + 1] += m_lb_tree[j * 2 + 1];
+            }
+        }
+        for (uint64_t lb_pos = 0; lb_pos < num_lbs; ++lb_pos) {
+            uint16_t* tree = get_sb_tree(lb_pos);
+            for (uint64_t j = 1; j <= SB_PER_LB; ++j) {
+                const uint64_t parent = j + lowbit(j);
+                if (parent <= SB_PER_LB) {
+                    tree[(parent - 1) * 2] += tree[(j - 1) * 2];
+                    tree[(parent - 1) * 2 + 1] += tree[(j - 1) * 2 + 1];
+                }
+            }
+        }
+    }
+
+    uint8_t get(uint64_t i) const {
+        assert(i < m_num_trits);
+        const uint8_t tryte = m_trytes[i / TRITS_PER_BYTE];
+        return uint8_t(detail::tryte_luts<>::EXPAND.table[tryte] >> (i % TRITS_PER_BYTE * 8));
+    }
+    uint8_t operator[](uint64_t i) const {
+        return get(i);
+    }
+
+    // Replaces the trit at position i with t.
+    void set(uint64_t i, uint8_t t) {
+        assert(i < m_num_trits);
+        assert(t < 3);
+
+        const uint8_t old = get(i);
+        if (old == t) {
+            return;
+        }
+        const uint8_t pow3 = get_pow3(i % TRITS_PER_BYTE);
+        m_trytes[i / TRITS_PER_BYTE] = uint8_t(m_trytes[i / TRITS_PER_BYTE] + t * pow3 - old * pow3);
+        if (old != 2) {
+            add(i, old, -1);
+        }
+        if (t != 2) {
+            add(i, t, 1);
+        }
+    }
+
+    void push_back(uint8_t t) {
+        assert(t < 3);
+
+        const uint64_t i = m_num_trits;
+        if (i % TRITS_PER_LB == 0) {
+            push_back_lb();
+        }
+        if (i % TRITS_PER_BYTE == 0) {
+            m_trytes.push_back(0);
+        }
+        m_trytes.back() = uint8_t(m_trytes.back() + t * get_pow3(i % TRITS_PER_BYTE));
+        ++m_num_trits;
+        if (t != 2) {
+            add(i, t, 1);
+        }
+    }
+
+    // Returns the numbers of occurrences of 0s, 1s and 2s between positions 0 and i-1.
+    std::array<uint64_t, 3> rank_all(const uint64_t i) const {
+        assert(i <= m_num_trits);
+
+        const uint64_t lb_pos = i / TRITS_PER_LB;
+        const uint64_t sb_pos = i / TRITS_PER_SB;
+        uint64_t rank_0 = 0, rank_1 = 0;
+        for (uint64_t j = lb_pos; j != 0; j -= lowbit(j)) {
+            rank_0 += m_lb_tree[j * 2];
+            rank_1 += m_lb_tree[j * 2 + 1];
+        }
+        if (sb_pos != lb_pos * SB_PER_LB) {
+            const uint16_t* tree = get_sb_tree(lb_pos);
+            for (uint64_t j = sb_pos - lb_pos * SB_PER_LB; j != 0; j -= lowbit(j)) {
+                rank_0 += tree[(j - 1) * 2];
+                rank_1 += tree[(j - 1) * 2 + 1];
+            }
+        }
+
+        const uint64_t tryte_pos = i / TRITS_PER_BYTE;
+        uint16_t cnt = 0;
+        for (uint64_t j = sb_pos * TRYTES_PER_SB; j < tryte_pos; ++j) {
+            cnt += get_lut(4, m_trytes[j]);
+        }
+        if (i % TRITS_PER_BYTE != 0) {
+            cnt += get_lut(i % TRITS_PER_BYTE - 1, m_trytes[tryte_pos]);
+        }
+
+        rank_0 += cnt & 0xFF;
+        rank_1 += cnt >> 8;
+        return {{rank_0, rank_1, i - rank_0 - rank_1}};
+    }
+
+    template <uint8_t Trit>
+    uint64_t rank(const uint64_t i) const {
+        static_assert(Trit < 3, "");
+        return rank_all(i)[Trit];
+    }
+
+    // Returns the position of the (n+1)-th occurrence of Trit.
+    template <uint8_t Trit>
+    uint64_t select(uint64_t n) const {
+        static_assert(Trit < 3, "");
+        assert(n < get_num_target_trits<Trit>());
+
+        // (1) Descend the tree of Large Blocks. The counts of 2s are derived from the lengths of the
+        // nodes, which may include the positions beyond the end; it does not matter since the answer
+        // is before them.
+        const uint64_t num_lbs = m_lb_tree.size() / 2 - 1;
+        uint64_t lb_pos = 0;
+        for (uint64_t step = highbit(num_lbs); step != 0; step >>= 1) {
+            if (lb_pos + step <= num_lbs) {
+                const uint64_t cnt = get_count<Trit>(&m_lb_tree[(lb_pos + step) * 2], step * TRITS_PER_LB);
+                if (cnt <= n) {
+                    lb_pos += step;
+                    n -= cnt;
+                }
+            }
+        }
+
+        // (2) Descend the tree of Small Blocks
+        const uint16_t* tree = get_sb_tree(lb_pos);
+        uint64_t sb_pos = 0;
+        for (uint64_t step = highbit(SB_PER_LB); step != 0; step >>= 1) {
+            if (sb_pos + step <= SB_PER_LB) {
+                const uint64_t cnt = get_count<Trit>(&tree[(sb_pos + step - 1) * 2], step * TRITS_PER_SB);
+                if (cnt <= n) {
+                    sb_pos += step;
+                    n -= cnt;
+                }
+            }
+        }
+
+        // (3) Search on the remaining trytes
+        uint64_t i = (lb_pos * SB_PER_LB + sb_pos) * TRYTES_PER_SB;
+        ++n;
+        for (;; ++i) {
+            const uint16_t cnt = get_lut(4, m_trytes[i]);
+            const uint64_t cnt_t = get_count<Trit>(cnt & 0xFF, cnt >> 8, TRITS_PER_BYTE);
+            if (n <= cnt_t) {
+                break;
+            }
+            n -= cnt_t;
+        }
+        return i * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][n - 1][m_trytes[i]];
+    }
+
+    uint64_t get_num_trits() const {
+        return m_num_trits;
+    }
+    template <uint8_t Trit>
+    uint64_t get_num_target_trits() const {
+        return rank<Trit>(m_num_trits);
+    }
+    uint64_t size_in_bytes() const {
+        return m_trytes.size() * sizeof(uint8_t) +  //
+               m_lb_tree.size() * sizeof(uint64_t) +  //
+               m_sb_tree.size() * sizeof(uint16_t) +  //
+               sizeof(m_num_trits);
+    }
+
+  private:
+    std::vector<uint8_t> m_trytes;  // each of 5 trits
+    std::vector<uint64_t> m_lb_tree;  // 1-origin Fenwick tree of the counts of 0s and 1s, interleaved
+    std::vector<uint16_t> m_sb_tree;  // 1-origin Fenwick trees for each large block, interleaved
+    uint64_t m_num_trits = 0;
+
+    static uint8_t get_pow3(uint64_t k) {
+        static constexpr uint8_t POW3[TRITS_PER_BYTE] = {1, 3, 9, 27, 81};
+        return POW3[k];
+    }
+    static uint64_t lowbit(uint64_t j) {
+        return j & (~j + 1);
+    }
+    static uint64_t highbit(uint64_t j) {
+        return j == 0 ? 0 : uint64_t(1) << (63 - __builtin_clzll(j));
+    }
+    static uint16_t get_lut(uint64_t k, uint8_t tryte) {
+        return detail::tryte_luts<>::FUSED.table[k][tryte];
+    }
+    template <uint8_t Trit>
+    static uint64_t get_count(uint64_t cnt_0, uint64_t cnt_1, uint64_t len) {
+        return Trit == 0 ? cnt_0 : Trit == 1 ? cnt_1 : len - cnt_0 - cnt_1;
+    }
+    template <uint8_t Trit, class T>
+    static uint64_t get_count(const T* node, uint64_t len) {
+        return get_count<Trit>(node[0], node[1], len);
+    }
+
+    // Node j (1 <= j <= SB_PER_LB) of the tree of a large block is at get_sb_tree(lb_pos)[(j - 1) * 2].
+    uint16_t* get_sb_tree(uint64_t lb_pos) {
+        return m_sb_tree.data() + lb_pos * SB_PER_LB * 2;
+    }
+    const uint16_t* get_sb_tree(uint64_t lb_pos) const {
+        return m_sb_tree.data() + lb_pos * SB_PER_LB * 2;
+    }
+
+    // Adds delta to the count of t (0 or 1) for position i.
+    void add(uint64_t i, uint8_t t, int delta) {
+        const uint64_t lb_pos = i / TRITS_PER_LB;
+        const uint64_t num_lbs = m_lb_tree.size() / 2 - 1;
+        for (uint64_t j = lb_pos + 1; j <= num_lbs; j += lowbit(j)) {
+            m_lb_tree[j * 2 + t] += uint64_t(int64_t(delta));
+        }
+        uint16_t* tree = get_sb_tree(lb_pos);
+        for (uint64_t j = i / TRITS_PER_SB - lb_pos * SB_PER_LB + 1; j <= SB_PER_LB; j += lowbit(j)) {
+            tree[(j - 1) * 2 + t] = uint16_t(tree[(j - 1) * 2 + t] + delta);
+        }
+    }
+
+    // Appends an empty large block.
+    void push_back_lb() {
+        if (m_lb_tree.empty()) {
+            m_lb_tree.assign(2, 0);  // dummy for the 1-origin index
+        }
+        // The new node j covers the large blocks in (j - lowbit(j), j], of which the last one is empty.
+        const uint64_t j = m_lb_tree.size() / 2;
+        uint64_t cnt_0 = 0, cnt_1 = 0;
+        for (uint64_t k = j - 1; k > j - lowbit(j); k -= lowbit(k)) {
+            cnt_0 += m_lb_tree[k * 2];
+            cnt_1 += m_lb_tree[k * 2 + 1];
+        }
+        m_lb_tree.push_back(cnt_0);
+        m_lb_tree.push_back(cnt_1);
+        m_sb_tree.resize(m_sb_tree.size() + SB_PER_LB * 2, 0);
+    }
+};
+
+}  // namespace succinctrits
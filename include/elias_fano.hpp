@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include "mappable_vector.hpp"
+
+namespace succinctrits {
+namespace detail {
+
+// Returns the position of the (k+1)-th set bit in x, for k < popcount(x).
+inline uint64_t select_in_word(uint64_t x, uint64_t k) {
+    assert(k < uint64_t(__builtin_popcountll(x)));
+#ifdef __BMI2__
+    return __builtin_ctzll(_pdep_u64(uint64_t(1) << k, x));
+#else
+    for (; k != 0; --k) {
+        x &= x - 1;
+    }
+    return __builtin_ctzll(x);
+#endif
+}
+
+}  // namespace detail
+
+// Elias-Fano representation of a non-decreasing sequence of integers less than universe.
+//
+// Each value is split into its lower low_width bits, which are packed as they are, and the upper bits,
+// which are stored in unary as the gaps of a bit array, taking about 2 + log2(universe / size) bits
+// per value. The positions of every SAMPLE_RATE-th 1 and 0 in the bit array are sampled, so that
+// select takes constant time and rank needs only a short scan within a bucket.
+class elias_fano {
+  public:
+    static constexpr uint64_t SAMPLE_RATE = 256;
+
+    elias_fano() = default;
+
+    elias_fano(const std::vector<uint64_t>& values, uint64_t universe) {
+        build(values.data(), values.size(), universe);
+    }
+
+    void build(const uint64_t* values, uint64_t num, uint64_t universe) {
+        m_size = num;
+        m_universe = universe;
+        m_low_width = 0;
+        while (num != 0 && (num << (m_low_width + 1)) <= universe) {
+            ++m_low_width;
+        }
+
+        const uint64_t num_high_bits = num + (universe >> m_low_width) + 1;
+        std::vector<uint64_t> low_bits((num * m_low_width + 63) / 64 + 1, 0);  // padded by a word
+        std::vector<uint64_t> high_bits((num_high_bits + 63) / 64, 0);
+
+        for (uint64_t i = 0; i < num; ++i) {
+            assert(values[i] < universe);
+            assert(i == 0 || values[i - 1] <= values[i]);
+            if (m_low_width != 0) {
+                const uint64_t low = values[i] & get_low_mask();
+                const uint64_t pos = i * m_low_width;
+                low_bits[pos / 64] |= low << (pos % 64);
+                if (pos % 64 + m_low_width > 64) {
+                    low_bits[pos / 64 + 1] |= low >> (64 - pos % 64);
+                }
+            }
+            const uint64_t pos = (values[i] >> m_low_width) + i;
+            high_bits[pos / 64] |= uint64_t(1) << (pos % 64);
+        }
+
+        std::vector<uint64_t> samples[2];
+        uint64_t counts[2] = {0, 0};
+        for (uint64_t pos = 0; pos < num_high_bits; ++pos) {
+            const uint64_t bit = high_bits[pos / 64] >> (pos % 64) & 1;
+            if (counts[bit] % SAMPLE_RATE == 0) {
+                samples[bit].push_back(pos);
+            }
+            ++counts[bit];
+        }
+
+        m_low_bits.steal(low_bits);
+        m_high_bits.steal(high_bits);
+        m_zero_samples.steal(samples[0]);
+        m_one_samples.steal(samples[1]);
+    }
+
+    // Moves the arrays into memory from resource, which must outlive this object.
+    void relocate(memory_resource* resource) {
+        m_low_bits.relocate(resource);
+        m_high_bits.relocate(resource);
+        m_zero_samples.relocate(resource);
+        m_one_samples.relocate(resource);
+    }
+
+    // Returns the (k+1)-th value, for k < size().
+    uint64_t select(uint64_t k) const {
+        assert(k < m_size);
+        const uint64_t high = select_bit<1>(k) - k;
+        return high << m_low_width | get_low(k);
+    }
+
+    // Returns the number of values less than x.
+    uint64_t rank(uint64_t x) const {
+        if (m_universe <= x) {
+            return m_size;
+        }
+        // The values whose upper bits are high follow the high-th 0 of the bit array.
+        const uint64_t high = x >> m_low_width;
+        uint64_t pos = high == 0 ? 0 : select_bit<0>(high - 1) + 1;
+        uint64_t i = pos - high;
+        const uint64_t low = x & get_low_mask();
+        for (; i < m_size && (m_high_bits[pos / 64] >> (pos % 64) & 1); ++i, ++pos) {
+            if (low <= get_low(i)) {
+                break;
+            }
+        }
+        return i;
+    }
+
+    uint64_t size() const {
+        return m_size;
+    }
+    uint64_t get_universe() const {
+        return m_universe;
+    }
+    uint64_t size_in_bytes() const {
+        return m_low_bits.size() * sizeof(uint64_t) +  //
+               m_high_bits.size() * sizeof(uint64_t) +  //
+               m_zero_samples.size() * sizeof(uint64_t) +  //
+               m_one_samples.size() * sizeof(uint64_t) +  //
+               sizeof(m_size) + sizeof(m_universe) + sizeof(m_low_width);
+    }
+
+    void save(std::ostream& os) const {
+        m_low_bits.save(os);
+        m_high_bits.save(os);
+        m_zero_samples.save(os);
+        m_one_samples.save(os);
+        os.write(reinterpret_cast<const char*>(&m_size), sizeof(m_size));
+        os.write(reinterpret_cast<const char*>(&m_universe), sizeof(m_universe));
+        os.write(reinterpret_cast<const char*>(&m_low_width), sizeof(m_low_width));
+    }
+    void load(std::istream& is) {
+        m_low_bits.load(is);
+        m_high_bits.load(is);
+        m_zero_samples.load(is);
+        m_one_samples.load(is);
+        is.read(reinterpret_cast<char*>(&m_size), sizeof(m_size));
+        is.read(reinterpret_cast<char*>(&m_universe), sizeof(m_universe));
+        is.read(reinterpret_cast<char*>(&m_low_width), sizeof(m_low_width));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    // Throws std::runtime_error if the data goes past end, unless end is nullptr.
+    const uint8_t* map(const uint8_t* ptr, const uint8_t* end = nullptr) {
+        ptr = m_low_bits.map(ptr, end);
+        ptr = m_high_bits.map(ptr, end);
+        ptr = m_zero_samples.map(ptr, end);
+        ptr = m_one_samples.map(ptr, end);
+        ptr = detail::map_value(ptr, end, &m_size);
+        ptr = detail::map_value(ptr, end, &m_universe);
+        return detail::map_value(ptr, end, &m_low_width);
+    }
+
+  private:
+    mappable_vector<uint64_t> m_low_bits;
+    mappable_vector<uint64_t> m_high_bits;
+    mappable_vector<uint64_t> m_zero_samples;  // positions of every SAMPLE_RATE-th 0 in m_high_bits
+    mappable_vector<uint64_t> m_one_samples;  // positions of every SAMPLE_RATE-th 1 in m_high_bits
+    uint64_t m_size = 0;
+    uint64_t m_universe = 0;
+    uint64_t m_low_width = 0;
+
+    uint64_t get_low_mask() const {
+        return (uint64_t(1) << m_low_width) - 1;
+    }
+    uint64_t get_low(uint64_t i) const {
+        if (m_low_width == 0) {
+            return 0;
+        }
+        const uint64_t pos = i * m_low_width;
+        uint64_t x = m_low_bits[pos / 64] >> (pos % 64);
+        if (pos % 64 + m_low_width > 64) {
+            x |= m_low_bits[pos / 64 + 1] << (64 - pos % 64);
+        }
+        return x & get_low_mask();
+    }
+
+    // Returns the position of the (k+1)-th Bit in m_high_bits.
+    template <uint64_t Bit>
+    uint64_t select_bit(uint64_t k) const {
+        const mappable_vector<uint64_t>& samples = Bit == 1 ? m_one_samples : m_zero_samples;
+        uint64_t pos = samples[k / SAMPLE_RATE];
+        k %= SAMPLE_RATE;
+
+        uint64_t word_pos = pos / 64;
+        uint64_t word = (Bit == 1 ? m_high_bits[word_pos] : ~m_high_bits[word_pos]) >> (pos % 64) << (pos % 64);
+        for (;;) {
+            const uint64_t cnt = __builtin_popcountll(word);
+            if (k < cnt) {
+                break;
+            }
+            k -= cnt;
+            ++word_pos;
+            word = Bit == 1 ? m_high_bits[word_pos] : ~m_high_bits[word_pos];
+        }
+        return word_pos * 64 + detail::select_in_word(word, k);
+    }
+};
+
+}  // namespace succinctrits
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "mappable_vector.hpp"
+#include "trit_vector.hpp"
+#include "tryte_lut.hpp"
+
+namespace succinctrits {
+
+// Predicates on trits for fused_rs_support::rank_if() and select_if(), given by the bit masks of the
+// trits satisfying them.
+template <uint8_t Trit>
+struct trit_eq {
+    static_assert(Trit < 3, "");
+    static constexpr uint8_t MASK = 1 << Trit;
+};
+template <uint8_t Trit>
+struct trit_ne {
+    static_assert(Trit < 3, "");
+    static constexpr uint8_t MASK = 7 ^ (1 << Trit);
+};
+template <uint8_t Trit>
+struct trit_lt {
+    static_assert(0 < Trit && Trit < 3, "no trit is less than 0");
+    static constexpr uint8_t MASK = (1 << Trit) - 1;
+};
+
+// Rank/Select support for all the three trits in a single index.
+// Only the counts of 0s and 1s are stored, since the count of 2s is derived from them.
+// Rank and select on predicates over trits (e.g., trits less than 2) are answered by the same
+// counters in the same time as on a single trit.
+class fused_rs_support {
+  public:
+    static constexpr uint64_t TRITS_PER_LB = 65550;
+    static constexpr uint64_t TRITS_PER_SB = 50;
+
+  private:
+    static constexpr uint64_t TRITS_PER_BYTE = trit_vector::TRITS_PER_BYTE;
+    static constexpr uint64_t TRYTES_PER_LB = TRITS_PER_LB / TRITS_PER_BYTE;  // 13110 trytes
+    static constexpr uint64_t TRYTES_PER_SB = TRITS_PER_SB / TRITS_PER_BYTE;  // 10 trytes
+    static constexpr uint64_t SB_PER_LB = TRITS_PER_LB / TRITS_PER_SB;  // 1311
+
+  public:
+    fused_rs_support() = default;
+
+    explicit fused_rs_support(const trit_vector* vec) {
+        build(vec);
+    }
+
+    void build(const trit_vector* vec) {
+        m_vec = vec;
+
+        std::vector<uint64_t> large_blocks;
+        std::vector<uint16_t> small_blocks;
+        large_blocks.reserve((m_vec->m_trytes.size() / TRYTES_PER_LB + 1) * 2);
+        small_blocks.reserve((m_vec->m_trytes.size() / TRYTES_PER_SB + 1) * 2);
+
+        // The blocks are also put at the end, so that rank_all(get_num_trits()) can be answered.
+        uint64_t rank_0 = 0, rank_1 = 0;
+        for (uint64_t i = 0; i <= m_vec->m_trytes.size(); ++i) {
+            if (i % TRYTES_PER_LB == 0) {
+                large_blocks.push_back(rank_0);
+                large_blocks.push_back(rank_1);
+            }
+            if (i % TRYTES_PER_SB == 0) {
+                const uint64_t lb_pos = large_blocks.size() - 2;
+                assert(rank_0 - large_blocks[lb_pos] <= UINT16_MAX);
+                assert(rank_1 - large_blocks[lb_pos + 1] <= UINT16_MAX);
+                small_blocks.push_back(uint16_t(rank_0 - large_blocks[lb_pos]));
+                small_blocks.push_back(uint16_t(rank_1 - large_blocks[lb_pos + 1]));
+            }
+            if (i < m_vec->m_trytes.size()) {
+                const uint16_t cnt = get_lut(4, m_vec->m_trytes[i]);
+                rank_0 += cnt & 0xFF;
+                rank_1 += cnt >> 8;
+            }
+        }
+        m_large_blocks.steal(large_blocks);
+        m_small_blocks.steal(small_blocks);
+
+        // Do not use rank_0 directly, since it includes the unused trits (i.e., 0s) in the last tryte.
+        const auto ranks = rank_all(m_vec->get_num_trits());
+        std::copy(ranks.begin(), ranks.end(), m_num_target_trits);
+    }
+
+    void set_vector(const trit_vector* vec) {
+        m_vec = vec;
+    }
+
+    uint8_t get(uint64_t i) const {
+        assert(m_vec != nullptr);
+        return m_vec->get(i);
+    }
+    uint8_t operator[](uint64_t i) const {
+        return get(i);
+    }
+
+    // Returns the numbers of occurrences of 0s, 1s and 2s in m_vec between positions 0 and i-1.
+    std::array<uint64_t, 3> rank_all(const uint64_t i) const {
+        assert(m_vec != nullptr);
+        assert(i <= m_vec->get_num_trits());
+
+        const uint64_t lb_pos = i / TRITS_PER_LB;
+        const uint64_t sb_pos = i / TRITS_PER_SB;
+        uint64_t rank_0 = m_large_blocks[lb_pos * 2] + m_small_blocks[sb_pos * 2];
+        uint64_t rank_1 = m_large_blocks[lb_pos * 2 + 1] + m_small_blocks[sb_pos * 2 + 1];
+
+        const uint64_t tryte_pos = i / TRITS_PER_BYTE;
+        const uint64_t tryte_beg = tryte_pos / TRYTES_PER_SB * TRYTES_PER_SB;
+
+        // The counts of 0s and 1s are summed up at once since each of them never exceeds 255.
+        uint16_t cnt = 0;
+        for (uint64_t j = tryte_beg; j < tryte_pos; ++j) {
+            cnt += get_lut(4, m_vec->m_trytes[j]);
+        }
+
+        const uint64_t k = i % TRITS_PER_BYTE;
+        if (k != 0) {
+            cnt += get_lut(k - 1, m_vec->m_trytes[tryte_pos]);
+        }
+
+        rank_0 += cnt & 0xFF;
+        rank_1 += cnt >> 8;
+        return {{rank_0, rank_1, i - rank_0 - rank_1}};
+    }
+
+    // Returns the number of occurrences of Trit in m_vec between positions 0 and i-1.
+    template <uint8_t Trit>
+    uint64_t rank(const uint64_t i) const {
+        static_assert(Trit < 3, "");
+        return rank_all(i)[Trit];
+    }
+
+    // Returns the position of the (n+1)-th occurrence of Trit in m_vec.
+    template <uint8_t Trit>
+    uint64_t select(uint64_t n) const {
+        static_assert(Trit < 3, "");
+        return select_mask<uint8_t(1 << Trit)>(n);
+    }
+
+    // Returns the number of trits satisfying Pred (e.g., trit_lt<2>) in m_vec between positions 0 and i-1.
+    template <class Pred>
+    uint64_t rank_if(const uint64_t i) const {
+        const auto ranks = rank_all(i);
+        return count_in<Pred::MASK>(ranks[0], ranks[1], ranks[2]);
+    }
+
+    // Returns the position of the (n+1)-th trit satisfying Pred (e.g., trit_ne<2>) in m_vec.
+    template <class Pred>
+    uint64_t select_if(uint64_t n) const {
+        return select_mask<Pred::MASK>(n);
+    }
+
+    uint64_t get_num_trits() const {
+        return m_vec->get_num_trits();
+    }
+    template <uint8_t Trit>
+    uint64_t get_num_target_trits() const {
+        static_assert(Trit < 3, "");
+        return m_num_target_trits[Trit];
+    }
+    // Returns the number of trits satisfying Pred in m_vec.
+    template <class Pred>
+    uint64_t get_num_target_trits_if() const {
+        return count_in<Pred::MASK>(m_num_target_trits[0], m_num_target_trits[1], m_num_target_trits[2]);
+    }
+    uint64_t size_in_bytes() const {
+        return m_large_blocks.size() * sizeof(uint64_t) +  //
+               m_small_blocks.size() * sizeof(uint16_t) +  //
+               sizeof(m_num_target_trits);
+    }
+
+    void save(std::ostream& os) const {
+        m_large_blocks.save(os);
+        m_small_blocks.save(os);
+        os.write(reinterpret_cast<const char*>(m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    void load(std::istream& is) {
+        m_large_blocks.load(is);
+        m_small_blocks.load(is);
+        is.read(reinterpret_cast<char*>(m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned, e.g., from mmap_file) without copying,
+    // and returns the pointer to the next data. The memory must outlive this object.
+    // Throws std::runtime_error if the data goes past end, unless end is nullptr.
+    const uint8_t* map(const uint8_t* ptr, const uint8_t* end = nullptr) {
+        ptr = m_large_blocks.map(ptr, end);
+        ptr = m_small_blocks.map(ptr, end);
+        return detail::map_value(ptr, end, &m_num_target_trits);
+    }
+
+  private:
+    const trit_vector* m_vec = nullptr;
+    mappable_vector<uint64_t> m_large_blocks;  // counts of 0s and 1s, interleaved
+    mappable_vector<uint16_t> m_small_blocks;  // counts of 0s and 1s, interleaved
+    uint64_t m_num_target_trits[3] = {0, 0, 0};
+
+    // Returns the sum of the counts of the trits in Mask.
+    template <uint8_t Mask>
+    static uint64_t count_in(uint64_t cnt_0, uint64_t cnt_1, uint64_t cnt_2) {
+        return (Mask & 1 ? cnt_0 : 0) + (Mask & 2 ? cnt_1 : 0) + (Mask & 4 ? cnt_2 : 0);
+    }
+
+    // Returns the position of the (n+1)-th occurrence of the trits in Mask.
+    template <uint8_t Mask>
+    uint64_t select_mask(uint64_t n) const {
+        static_assert(0 < Mask && Mask < 8, "");
+        assert(m_vec != nullptr);
+        assert(n < count_in<Mask>(m_num_target_trits[0], m_num_target_trits[1], m_num_target_trits[2]));
+
+        // (1) Search on Large Blocks
+        uint64_t left = 0;
+        uint64_t right = m_large_blocks.size() / 2;
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < get_lb_count<Mask>(center)) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+        assert(get_lb_count<Mask>(left) <= n);
+
+        // (2) Search on Small Blocks
+        n = n - get_lb_count<Mask>(left);
+
+        const uint64_t sb_beg = left * SB_PER_LB;  // position of SB
+        left = sb_beg;
+        right = std::min<uint64_t>(left + SB_PER_LB, m_small_blocks.size() / 2);
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < get_sb_count<Mask>(center, sb_beg)) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+        uint64_t i = left;
+        assert(get_sb_count<Mask>(i, sb_beg) <= n);
+
+        // (3) Search on the remaining trytes
+        n = n - get_sb_count<Mask>(i, sb_beg);
+        i = i * TRYTES_PER_SB;  // position of trytes
+
+        ++n;
+
+        for (;; ++i) {
+            const uint64_t cnt = get_tryte_count<Mask>(4, m_vec->m_trytes[i]);
+            if (n <= cnt) {
+                break;
+            }
+            n = n - cnt;
+        }
+
+        const uint8_t tryte = m_vec->m_trytes[i];
+        assert(n <= get_tryte_count<Mask>(4, tryte));
+        return i * TRITS_PER_BYTE + detail::tryte_luts<>::PRED.select[Mask][n - 1][tryte];
+    }
+
+    static uint16_t get_lut(uint64_t k, uint8_t tryte) {
+        return detail::tryte_luts<>::FUSED.table[k][tryte];
+    }
+    template <uint8_t Mask>
+    uint64_t get_lb_count(uint64_t lb_pos) const {
+        const uint64_t cnt_0 = m_large_blocks[lb_pos * 2];
+        const uint64_t cnt_1 = m_large_blocks[lb_pos * 2 + 1];
+        return count_in<Mask>(cnt_0, cnt_1, lb_pos * TRITS_PER_LB - cnt_0 - cnt_1);
+    }
+    template <uint8_t Mask>
+    uint64_t get_sb_count(uint64_t sb_pos, uint64_t sb_beg) const {
+        const uint64_t cnt_0 = m_small_blocks[sb_pos * 2];
+        const uint64_t cnt_1 = m_small_blocks[sb_pos * 2 + 1];
+        return count_in<Mask>(cnt_0, cnt_1, (sb_pos - sb_beg) * TRITS_PER_SB - cnt_0 - cnt_1);
+    }
+    // Returns the number of the trits in Mask in the first k+1 trits of the tryte.
+    template <uint8_t Mask>
+    static uint64_t get_tryte_count(uint64_t k, uint8_t tryte) {
+        return detail::tryte_luts<>::PRED.count[Mask][k][tryte];
+    }
+};
+
+}  // namespace succinctrits
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "mappable_vector.hpp"
+#include "memory_resource.hpp"
+#include "tryte_lut.hpp"
+#include "tryte_simd.hpp"
+
+namespace succinctrits {
+
+// Trit vector with Rank/Select support on Trit in a single cache-line-interleaved array, replacing
+// the pair of trit_vector and rs_support<Trit>.
+//
+// Every 64-byte line covers 280 trits: an 8-byte header followed by 56 trytes, split into four
+// sub-blocks of 14 trytes. The header packs the count of Trit before the line in 40 bits and the
+// counts before the 2nd, 3rd and 4th sub-blocks relative to the line in 8 bits each:
+//
+//   | base (40) | c1 (8) | c2 (8) | c3 (8) | 56 trytes |
+//
+// so that access and rank read a single cache line, like rank9 on bit vectors. Select searches
+// sampled lines by their bases and then reads one line.
+template <uint8_t Trit>
+class interleaved_rs_vector {
+  public:
+    static_assert(Trit < 3, "");
+
+    static constexpr uint64_t TRITS_PER_BYTE = 5;
+    static constexpr uint64_t TRYTES_PER_SUB = 14;
+    static constexpr uint64_t TRITS_PER_SUB = TRYTES_PER_SUB * TRITS_PER_BYTE;  // 70 trits
+    static constexpr uint64_t SUBS_PER_LINE = 4;
+    static constexpr uint64_t TRITS_PER_LINE = TRITS_PER_SUB * SUBS_PER_LINE;  // 280 trits
+    static constexpr uint64_t SELECT_SAMPLE_RATE = 1024;
+
+  private:
+    static constexpr uint64_t WORDS_PER_LINE = 8;
+    static constexpr uint64_t BASE_BITS = 40;
+    static constexpr uint64_t BASE_MASK = (uint64_t(1) << BASE_BITS) - 1;
+
+  public:
+    interleaved_rs_vector() = default;
+
+    template <class Iterator>
+    interleaved_rs_vector(Iterator it, uint64_t num_trits) {
+        build(it, num_trits);
+    }
+
+    // The trits are given by the iterator, e.g., std::vector<uint8_t>::const_iterator or
+    // trit_vector::const_iterator.
+    template <class Iterator>
+    void build(Iterator it, uint64_t num_trits) {
+        assert(num_trits < (uint64_t(1) << BASE_BITS));
+
+        // One more line is put at the end, so that rank(get_num_trits()) can be answered.
+        const uint64_t num_lines = num_trits / TRITS_PER_LINE + 1;
+        std::vector<uint64_t> lines(num_lines * WORDS_PER_LINE);
+        std::vector<uint64_t> select_samples;
+        select_samples.reserve(num_trits / SELECT_SAMPLE_RATE + 2);
+
+        uint64_t rank = 0;
+        for (uint64_t line_pos = 0; line_pos < num_lines; ++line_pos) {
+            uint64_t* line = lines.data() + line_pos * WORDS_PER_LINE;
+            uint8_t* trytes = reinterpret_cast<uint8_t*>(line + 1);
+            const uint64_t base = rank;
+            uint64_t header = base;
+
+            for (uint64_t j = 0; j < TRITS_PER_LINE; ++j) {
+                if (j % TRITS_PER_SUB == 0 && j != 0) {
+                    header |= (rank - base) << (BASE_BITS + (j / TRITS_PER_SUB - 1) * 8);
+                }
+                if (line_pos * TRITS_PER_LINE + j < num_trits) {
+                    const uint8_t t = *it;
+                    ++it;
+                    assert(t < 3);
+                    trytes[j / TRITS_PER_BYTE] += t * pow3(j % TRITS_PER_BYTE);
+                    rank += t == Trit;
+                }
+            }
+            line[0] = header;
+
+            // The lines including every SELECT_SAMPLE_RATE-th occurrence
+            while (select_samples.size() * SELECT_SAMPLE_RATE < rank) {
+                select_samples.push_back(line_pos);
+            }
+        }
+        select_samples.push_back(num_lines - 1);
+
+        // The lines are copied to memory aligned to cache lines.
+        m_lines.steal(lines);
+        m_lines.relocate(cache_aligned_resource::get());
+        m_select_samples.steal(select_samples);
+        m_num_trits = num_trits;
+        m_num_target_trits = rank;
+    }
+    void build_from_span(const uint8_t* trits, uint64_t num_trits) {
+        build(trits, num_trits);
+    }
+
+    uint8_t get(uint64_t i) const {
+        assert(i < m_num_trits);
+        const uint64_t j = i % TRITS_PER_LINE;
+        const uint8_t tryte = get_trytes(i / TRITS_PER_LINE)[j / TRITS_PER_BYTE];
+        return uint8_t(detail::tryte_luts<>::EXPAND.table[tryte] >> (j % TRITS_PER_BYTE * 8));
+    }
+    uint8_t operator[](uint64_t i) const {
+        return get(i);
+    }
+
+    // Returns the number of Trit between positions 0 and i-1, for i <= get_num_trits().
+    uint64_t rank(uint64_t i) const {
+        assert(i <= m_num_trits);
+
+        const uint64_t line_pos = i / TRITS_PER_LINE;
+        const uint64_t j = i % TRITS_PER_LINE;
+        const uint64_t sub = j / TRITS_PER_SUB;
+        const uint64_t header = m_lines[line_pos * WORDS_PER_LINE];
+
+        uint64_t rank = (header & BASE_MASK) + get_sub_rank(header, sub);
+        rank += count_in_sub(get_trytes(line_pos), sub, j - sub * TRITS_PER_SUB);
+        return rank;
+    }
+
+    // Returns the position of the (n+1)-th occurrence of Trit, for n < get_num_target_trits().
+    uint64_t select(uint64_t n) const {
+        assert(n < m_num_target_trits);
+
+        // (1) Search on the bases of the sampled lines
+        const uint64_t x = n / SELECT_SAMPLE_RATE;
+        uint64_t left = m_select_samples[x];
+        uint64_t right = m_select_samples[x + 1] + 1;
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < (m_lines[center * WORDS_PER_LINE] & BASE_MASK)) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+
+        // (2) Search on the sub-blocks in the header
+        const uint64_t header = m_lines[left * WORDS_PER_LINE];
+        n -= header & BASE_MASK;
+        uint64_t sub = 0;
+        for (uint64_t s = 1; s < SUBS_PER_LINE; ++s) {
+            sub += get_sub_rank(header, s) <= n;
+        }
+        n -= get_sub_rank(header, sub);
+
+        // (3) Search on the trytes of the sub-block
+        const uint8_t* trytes = get_trytes(left) + sub * TRYTES_PER_SUB;
+        uint64_t k = 0;  // position of the tryte
+        ++n;
+        const auto select_tryte = detail::get_kernels().select_tryte[Trit];
+        if (select_tryte != nullptr) {
+            if (sub + 1 < SUBS_PER_LINE) {
+                k = select_tryte(trytes, n);
+            } else {
+                // The 16 trytes read from the last 2 trytes of the 3rd sub-block (see count_in_sub())
+                n += count_in_tryte(TRITS_PER_BYTE, trytes[-2]) + count_in_tryte(TRITS_PER_BYTE, trytes[-1]);
+                k = select_tryte(trytes - 2, n) - 2;
+            }
+        } else {
+            for (;; ++k) {
+                const uint64_t cnt = count_in_tryte(TRITS_PER_BYTE, trytes[k]);
+                if (n <= cnt) {
+                    break;
+                }
+                n -= cnt;
+            }
+        }
+        return left * TRITS_PER_LINE + (sub * TRYTES_PER_SUB + k) * TRITS_PER_BYTE +
+               detail::tryte_luts<>::SELECT.table[Trit][n - 1][trytes[k]];
+    }
+
+    uint64_t get_num_trits() const {
+        return m_num_trits;
+    }
+    uint64_t size() const {
+        return m_num_trits;
+    }
+    uint64_t get_num_target_trits() const {
+        return m_num_target_trits;
+    }
+    uint64_t size_in_bytes() const {
+        return m_lines.size() * sizeof(uint64_t) + m_select_samples.size() * sizeof(uint64_t) +
+               sizeof(m_num_trits) + sizeof(m_num_target_trits);
+    }
+
+    // Moves the arrays into memory from resource, which must outlive this object. The resource
+    // should return memory aligned to 64 bytes, as huge_page_resource and numa_resource do.
+    void relocate(memory_resource* resource) {
+        m_lines.relocate(resource);
+        m_select_samples.relocate(resource);
+    }
+
+    void save(std::ostream& os) const {
+        m_lines.save(os);
+        m_select_samples.save(os);
+        os.write(reinterpret_cast<const char*>(&m_num_trits), sizeof(m_num_trits));
+        os.write(reinterpret_cast<const char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    void load(std::istream& is) {
+        m_lines.load(is);
+        m_lines.relocate(cache_aligned_resource::get());
+        m_select_samples.load(is);
+        is.read(reinterpret_cast<char*>(&m_num_trits), sizeof(m_num_trits));
+        is.read(reinterpret_cast<char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object. The lines are aligned to cache lines
+    // only if ptr + 8 is.
+    const uint8_t* map(const uint8_t* ptr) {
+        ptr = m_lines.map(ptr);
+        ptr = m_select_samples.map(ptr);
+        std::memcpy(&m_num_trits, ptr, sizeof(m_num_trits));
+        ptr += sizeof(m_num_trits);
+        std::memcpy(&m_num_target_trits, ptr, sizeof(m_num_target_trits));
+        return ptr + sizeof(m_num_target_trits);
+    }
+
+  private:
+    mappable_vector<uint64_t> m_lines;
+    mappable_vector<uint64_t> m_select_samples;  // lines including every SELECT_SAMPLE_RATE-th Trit
+    uint64_t m_num_trits = 0;
+    uint64_t m_num_target_trits = 0;
+
+    static constexpr uint8_t pow3(uint64_t k) {
+        return k == 0 ? 1 : 3 * pow3(k - 1);
+    }
+
+    const uint8_t* get_trytes(uint64_t line_pos) const {
+        return reinterpret_cast<const uint8_t*>(m_lines.data() + line_pos * WORDS_PER_LINE + 1);
+    }
+
+    // Returns the count of Trit before the sub-block relative to the line.
+    static uint64_t get_sub_rank(uint64_t header, uint64_t sub) {
+        return sub == 0 ? 0 : header >> (BASE_BITS + (sub - 1) * 8) & 0xFF;
+    }
+
+    // Returns the number of Trit in the first k (<= 5) trits of the tryte.
+    static uint64_t count_in_tryte(uint64_t k, uint8_t tryte) {
+        if (k == 0) {
+            return 0;
+        }
+        const uint16_t cnt = detail::tryte_luts<>::FUSED.table[k - 1][tryte];
+        return Trit == 0 ? cnt & 0xFF : (Trit == 1 ? cnt >> 8 : k - (cnt & 0xFF) - (cnt >> 8));
+    }
+
+    // Returns the number of Trit in the first k (< 70) trits of the sub-block.
+    static uint64_t count_in_sub(const uint8_t* trytes, uint64_t sub, uint64_t k) {
+        const auto count_trits = detail::get_kernels().count_trits[Trit];
+        if (count_trits != nullptr) {
+            if (sub + 1 < SUBS_PER_LINE) {
+                return count_trits(trytes + sub * TRYTES_PER_SUB, k);
+            }
+            // The kernels read 16 trytes, so the last sub-block is read with the 2 trytes before it
+            // not to go beyond the line.
+            const uint64_t cnt = count_trits(trytes + 40, k + 2 * TRITS_PER_BYTE);
+            return cnt - count_in_tryte(TRITS_PER_BYTE, trytes[40]) - count_in_tryte(TRITS_PER_BYTE, trytes[41]);
+        }
+        trytes += sub * TRYTES_PER_SUB;
+        uint64_t cnt = 0;
+        for (; TRITS_PER_BYTE <= k; k -= TRITS_PER_BYTE) {
+            cnt += count_in_tryte(TRITS_PER_BYTE, *trytes++);
+        }
+        return cnt + count_in_tryte(k, *trytes);
+    }
+};
+
+}  // namespace succinctrits
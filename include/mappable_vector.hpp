@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "memory_resource.hpp"
+
+namespace succinctrits {
+namespace detail {
+
+// Copies the value of T at ptr into *value, and returns the pointer to the next data.
+// Throws std::runtime_error if the value goes past end, unless end is nullptr.
+template <class T>
+inline const uint8_t* map_value(const uint8_t* ptr, const uint8_t* end, T* value) {
+    if (end != nullptr && (end < ptr || uint64_t(end - ptr) < sizeof(T))) {
+        throw std::runtime_error("broken mapped data");
+    }
+    std::memcpy(value, ptr, sizeof(T));
+    return ptr + sizeof(T);
+}
+
+}  // namespace detail
+
+// Read-only array that either owns its elements, in a std::vector or in memory from a
+// memory_resource, or views an external memory region such as a memory-mapped file.
+//
+// The serialized form is the number of elements (size_t) followed by the elements padded to a
+// multiple of 8 bytes, so that every array in a file saved from an 8-byte aligned position can be
+// viewed in place.
+template <class T>
+class mappable_vector {
+  public:
+    static constexpr uint64_t ALIGNMENT = 8;
+
+    mappable_vector() = default;
+
+    explicit mappable_vector(std::vector<T>&& vec) {
+        steal(vec);
+    }
+
+    ~mappable_vector() {
+        release();
+    }
+
+    mappable_vector(const mappable_vector& other) {
+        *this = other;
+    }
+    mappable_vector& operator=(const mappable_vector& other) {
+        if (this != &other) {
+            release();
+            m_vec = other.m_vec;
+            m_data = other.is_mapped() ? other.m_data : m_vec.data();
+            m_size = other.m_size;
+            if (other.m_resource != nullptr) {
+                // The copy is placed in the same resource.
+                m_data = other.m_data;
+                relocate(other.m_resource);
+            }
+        }
+        return *this;
+    }
+
+    mappable_vector(mappable_vector&& other) noexcept {
+        *this = std::move(other);
+    }
+    mappable_vector& operator=(mappable_vector&& other) noexcept {
+        if (this != &other) {
+            release();
+            // The buffer of m_vec is kept by the move, so m_data remains valid.
+            m_vec = std::move(other.m_vec);
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_resource = other.m_resource;
+            other.m_resource = nullptr;
+            other.clear();
+        }
+        return *this;
+    }
+
+    // Takes the elements of vec, leaving vec empty.
+    void steal(std::vector<T>& vec) {
+        release();
+        m_vec.swap(vec);
+        m_data = m_vec.data();
+        m_size = m_vec.size();
+        std::vector<T>().swap(vec);
+    }
+
+    void clear() {
+        release();
+        std::vector<T>().swap(m_vec);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    // Copies the elements into memory from resource, which must outlive this object, and frees
+    // the previous memory. A mapped array is copied as well and no longer refers to the region.
+    void relocate(memory_resource* resource) {
+        assert(resource != nullptr);
+        if (m_size == 0) {
+            return;
+        }
+        T* data = static_cast<T*>(resource->allocate(sizeof(T) * m_size));
+        std::memcpy(data, m_data, sizeof(T) * m_size);
+        release();
+        std::vector<T>().swap(m_vec);
+        m_data = data;
+        m_resource = resource;
+    }
+
+    const T& operator[](uint64_t i) const {
+        assert(i < m_size);
+        return m_data[i];
+    }
+    const T* data() const {
+        return m_data;
+    }
+    const T* begin() const {
+        return m_data;
+    }
+    const T* end() const {
+        return m_data + m_size;
+    }
+    const T& back() const {
+        assert(m_size != 0);
+        return m_data[m_size - 1];
+    }
+    uint64_t size() const {
+        return m_size;
+    }
+    bool empty() const {
+        return m_size == 0;
+    }
+    bool is_mapped() const {
+        return m_resource == nullptr && m_data != m_vec.data();
+    }
+    // Returns the resource holding the elements, or nullptr if they are not in one.
+    memory_resource* get_resource() const {
+        return m_resource;
+    }
+
+    void save(std::ostream& os) const {
+        const size_t n = m_size;
+        os.write(reinterpret_cast<const char*>(&n), sizeof(size_t));
+        os.write(reinterpret_cast<const char*>(m_data), sizeof(T) * n);
+        static const char zeros[ALIGNMENT] = {};
+        os.write(zeros, get_padding(n));
+    }
+    // The elements are read in chunks, so that a broken count stops the stream at its end instead of
+    // allocating the whole count.
+    void load(std::istream& is) {
+        size_t n = 0;
+        is.read(reinterpret_cast<char*>(&n), sizeof(size_t));
+        std::vector<T> vec;
+        for (uint64_t i = 0; i < n && is;) {
+            const uint64_t num = std::min<uint64_t>(n - i, uint64_t(LOAD_CHUNK));
+            vec.resize(i + num);
+            is.read(reinterpret_cast<char*>(vec.data() + i), std::streamsize(sizeof(T) * num));
+            i += num;
+        }
+        is.ignore(get_padding(n));
+        steal(vec);
+    }
+    // Views the serialized array at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    // Throws std::runtime_error if the array goes past end, unless end is nullptr.
+    const uint8_t* map(const uint8_t* ptr, const uint8_t* end = nullptr) {
+        assert(reinterpret_cast<uintptr_t>(ptr) % ALIGNMENT == 0);
+        size_t n = 0;
+        ptr = detail::map_value(ptr, end, &n);
+        if (end != nullptr &&
+            (uint64_t(end - ptr) / sizeof(T) < n || uint64_t(end - ptr) - sizeof(T) * n < get_padding(n))) {
+            throw std::runtime_error("broken mapped array of " + std::to_string(n) + " elements");
+        }
+        release();
+        std::vector<T>().swap(m_vec);
+        m_data = reinterpret_cast<const T*>(ptr);
+        m_size = n;
+        return ptr + sizeof(T) * n + get_padding(n);
+    }
+
+  private:
+    static constexpr uint64_t LOAD_CHUNK = (uint64_t(1) << 24) / sizeof(T);  // 16 MiB
+
+    std::vector<T> m_vec;
+    const T* m_data = nullptr;
+    uint64_t m_size = 0;
+    memory_resource* m_resource = nullptr;  // owning m_data if not nullptr
+
+    // Frees the memory from m_resource, if any.
+    void release() {
+        if (m_resource != nullptr) {
+            m_resource->deallocate(const_cast<T*>(m_data), sizeof(T) * m_size);
+            m_resource = nullptr;
+            m_data = m_vec.data();
+        }
+    }
+
+    static uint64_t get_padding(uint64_t n) {
+        return (ALIGNMENT - sizeof(T) * n % ALIGNMENT) % ALIGNMENT;
+    }
+};
+
+}  // namespace succinctrits
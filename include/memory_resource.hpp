@@ -0,0 +1,200 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace succinctrits {
+
+// Source of the memory for the arrays of trit_vector, rs_support and so on, like
+// std::pmr::memory_resource in C++17. The arrays are moved to a resource by their relocate(), and
+// the resource must outlive them.
+class memory_resource {
+  public:
+    virtual ~memory_resource() = default;
+
+    // Returns memory of bytes (!= 0) aligned for any scalar type, or throws std::bad_alloc.
+    virtual void* allocate(uint64_t bytes) = 0;
+    // Frees the memory returned by allocate(bytes).
+    virtual void deallocate(void* ptr, uint64_t bytes) = 0;
+};
+
+namespace detail {
+
+inline uint64_t round_up_to_page(uint64_t bytes) {
+    const uint64_t page_size = uint64_t(::sysconf(_SC_PAGESIZE));
+    return (bytes + page_size - 1) / page_size * page_size;
+}
+
+// Maps anonymous memory of bytes aligned to alignment (a multiple of the page size) by trimming a
+// larger mapping. It is unmapped by munmap(ptr, round_up_to_page(bytes)).
+inline void* map_aligned(uint64_t bytes, uint64_t alignment) {
+    bytes = round_up_to_page(bytes);
+    void* addr = ::mmap(nullptr, bytes + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    const uintptr_t beg = reinterpret_cast<uintptr_t>(addr);
+    const uintptr_t aligned = (beg + alignment - 1) / alignment * alignment;
+    if (aligned != beg) {
+        ::munmap(addr, aligned - beg);
+    }
+    ::munmap(reinterpret_cast<void*>(aligned + bytes), beg + alignment - aligned);
+    return reinterpret_cast<void*>(aligned);
+}
+
+}  // namespace detail
+
+// Plain operator new and delete
+class new_delete_resource : public memory_resource {
+  public:
+    void* allocate(uint64_t bytes) override {
+        return ::operator new(bytes);
+    }
+    void deallocate(void* ptr, uint64_t) override {
+        ::operator delete(ptr);
+    }
+};
+
+// Memory aligned to a cache line (64 bytes) by posix_memalign, e.g., for interleaved_rs_vector
+class cache_aligned_resource : public memory_resource {
+  public:
+    static constexpr uint64_t ALIGNMENT = 64;
+
+    void* allocate(uint64_t bytes) override {
+        void* ptr = nullptr;
+        if (::posix_memalign(&ptr, ALIGNMENT, bytes) != 0) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+    void deallocate(void* ptr, uint64_t) override {
+        std::free(ptr);
+    }
+
+    // Returns the instance shared by the whole program.
+    static cache_aligned_resource* get() {
+        static cache_aligned_resource resource;
+        return &resource;
+    }
+};
+
+// Memory backed by huge pages to reduce TLB misses on random queries.
+//
+// Explicit huge pages (MAP_HUGETLB) are tried first, which need pages reserved in
+// /proc/sys/vm/nr_hugepages (or the 1 GB pool). If none are available, the memory is aligned to
+// 2 MB and advised to be backed by transparent huge pages (MADV_HUGEPAGE) instead.
+class huge_page_resource : public memory_resource {
+  public:
+    static constexpr uint64_t SIZE_2MB = uint64_t(1) << 21;
+    static constexpr uint64_t SIZE_1GB = uint64_t(1) << 30;
+
+    explicit huge_page_resource(uint64_t page_size = SIZE_2MB) : m_page_size(page_size) {
+        assert(page_size == SIZE_2MB || page_size == SIZE_1GB);
+    }
+
+    void* allocate(uint64_t bytes) override {
+        assert(bytes != 0);
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+        const int log_page_size = m_page_size == SIZE_1GB ? 30 : 21;
+        void* addr = ::mmap(nullptr, round_up(bytes), PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (log_page_size << MAP_HUGE_SHIFT), -1, 0);
+        if (addr != MAP_FAILED) {
+            ++m_num_huge_pages;
+            return addr;
+        }
+#endif
+        // Mapped in the same length as the huge pages, so that deallocate() needs not know which
+        void* ptr = detail::map_aligned(round_up(bytes), SIZE_2MB);
+#ifdef MADV_HUGEPAGE
+        ::madvise(ptr, round_up(bytes), MADV_HUGEPAGE);
+#endif
+        ++m_num_fallbacks;
+        return ptr;
+    }
+    void deallocate(void* ptr, uint64_t bytes) override {
+        ::munmap(ptr, round_up(bytes));
+    }
+
+    uint64_t get_page_size() const {
+        return m_page_size;
+    }
+    // Returns the number of allocations backed by explicit huge pages.
+    uint64_t get_num_huge_pages() const {
+        return m_num_huge_pages;
+    }
+    // Returns the number of allocations that fell back to transparent huge pages.
+    uint64_t get_num_fallbacks() const {
+        return m_num_fallbacks;
+    }
+
+  private:
+    uint64_t m_page_size = SIZE_2MB;
+    uint64_t m_num_huge_pages = 0;
+    uint64_t m_num_fallbacks = 0;
+
+    uint64_t round_up(uint64_t bytes) const {
+        return (bytes + m_page_size - 1) / m_page_size * m_page_size;
+    }
+};
+
+// Memory placed on NUMA nodes by mbind(2) before the first touch.
+//  - interleave: pages round-robin over the nodes in the mask, so that concurrent queries from
+//    every socket see the same average latency
+//  - local: pages on the node of the thread that first touches them, i.e., the one calling relocate()
+//  - bind: pages only on the nodes in the mask
+// On kernels or machines without NUMA, mbind fails and the memory is used as it is.
+class numa_resource : public memory_resource {
+  public:
+    enum class policy { interleave, local, bind };
+
+    // The bits of node_mask are the node IDs; the default covers all nodes up to 64.
+    explicit numa_resource(policy p = policy::interleave, uint64_t node_mask = ~uint64_t(0))
+        : m_policy(p), m_node_mask(node_mask) {}
+
+    void* allocate(uint64_t bytes) override {
+        assert(bytes != 0);
+        void* ptr = detail::map_aligned(bytes, SIZE_2MB);
+#ifdef MADV_HUGEPAGE
+        ::madvise(ptr, detail::round_up_to_page(bytes), MADV_HUGEPAGE);
+#endif
+#if defined(__linux__) && defined(SYS_mbind)
+        // The constants of <numaif.h>, which is not included to avoid depending on libnuma
+        const int mode = m_policy == policy::interleave ? 3 : (m_policy == policy::bind ? 2 : 4);
+        const unsigned long mask = m_node_mask;
+        const unsigned long* mask_ptr = m_policy == policy::local ? nullptr : &mask;  // maxnode is 64 + 1
+        if (::syscall(SYS_mbind, ptr, detail::round_up_to_page(bytes), mode, mask_ptr, 65, 0) == 0) {
+            ++m_num_bound;
+        }
+#endif
+        return ptr;
+    }
+    void deallocate(void* ptr, uint64_t bytes) override {
+        ::munmap(ptr, detail::round_up_to_page(bytes));
+    }
+
+    policy get_policy() const {
+        return m_policy;
+    }
+    // Returns the number of allocations for which mbind succeeded.
+    uint64_t get_num_bound() const {
+        return m_num_bound;
+    }
+
+  private:
+    static constexpr uint64_t SIZE_2MB = uint64_t(1) << 21;
+
+    policy m_policy = policy::interleave;
+    uint64_t m_node_mask = ~uint64_t(0);
+    uint64_t m_num_bound = 0;
+};
+
+}  // namespace succinctrits
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace succinctrits {
+
+// Read-only memory mapping of a whole file.
+// The data structures mapped from it refer to the memory, so it must outlive them.
+class mmap_file {
+  public:
+    mmap_file() = default;
+
+    explicit mmap_file(const char* path) {
+        open(path);
+    }
+    ~mmap_file() {
+        close();
+    }
+
+    mmap_file(const mmap_file&) = delete;
+    mmap_file& operator=(const mmap_file&) = delete;
+
+    mmap_file(mmap_file&& other) noexcept {
+        *this = std::move(other);
+    }
+    mmap_file& operator=(mmap_file&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = other.m_data;
+            m_size = other.m_size;
+            other.m_data = nullptr;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    void open(const char* path) {
+        close();
+
+        const int fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error(std::string("failed to open ") + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == -1) {
+            ::close(fd);
+            throw std::runtime_error(std::string("failed to stat ") + path);
+        }
+        m_size = uint64_t(st.st_size);
+
+        if (m_size != 0) {
+            void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                m_size = 0;
+                throw std::runtime_error(std::string("failed to mmap ") + path);
+            }
+            m_data = static_cast<const uint8_t*>(addr);
+        }
+        ::close(fd);  // the mapping remains valid
+    }
+
+    void close() {
+        if (m_data != nullptr) {
+            ::munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    // The address is page-aligned.
+    const uint8_t* data() const {
+        return m_data;
+    }
+    uint64_t size() const {
+        return m_size;
+    }
+
+  private:
+    const uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+};
+
+}  // namespace succinctrits
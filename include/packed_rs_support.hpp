@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "mappable_vector.hpp"
+#include "packed_trit_vector.hpp"
+#include "tryte_lut.hpp"
+
+namespace succinctrits {
+
+// Rank/Select support on packed_trit_vector<Packing>.
+//
+// The directories are the same as rs_support, i.e., the counts of Trit before every large block and
+// the counts relative to the large block before every small block, but are laid out in blocks of the
+// packing. The blocks in a small block are decoded into trytes to be counted, so rank and select take
+// constant time for any packing.
+template <uint8_t Trit, class Packing>
+class packed_rs_support {
+  public:
+    static_assert(Trit < 3, "");
+
+    static constexpr uint64_t TRITS_PER_BLOCK = Packing::TRITS_PER_BLOCK;
+    static constexpr uint64_t TRITS_PER_SB = TRITS_PER_BLOCK * Packing::BLOCKS_PER_SB;
+    static constexpr uint64_t TRITS_PER_LB = TRITS_PER_SB * Packing::SB_PER_LB;
+
+    static_assert(TRITS_PER_LB - TRITS_PER_SB <= UINT16_MAX, "small blocks must fit in 16 bits");
+
+  private:
+    static constexpr uint64_t TRYTES_PER_BLOCK = Packing::TRYTES_PER_BLOCK;
+    static constexpr uint64_t BLOCKS_PER_SB = Packing::BLOCKS_PER_SB;
+    static constexpr uint64_t SB_PER_LB = Packing::SB_PER_LB;
+
+  public:
+    packed_rs_support() = default;
+
+    explicit packed_rs_support(const packed_trit_vector<Packing>* vec) {
+        build(vec);
+    }
+
+    void build(const packed_trit_vector<Packing>* vec) {
+        m_vec = vec;
+
+        const uint64_t num_blocks = (vec->get_num_trits() + TRITS_PER_BLOCK - 1) / TRITS_PER_BLOCK;
+        std::vector<uint64_t> large_blocks;
+        std::vector<uint16_t> small_blocks;
+        large_blocks.reserve(num_blocks / (BLOCKS_PER_SB * SB_PER_LB) + 1);
+        small_blocks.reserve(num_blocks / BLOCKS_PER_SB + 1);
+
+        uint64_t rank = 0;
+        for (uint64_t block_pos = 0; block_pos < num_blocks; ++block_pos) {
+            if (block_pos % (BLOCKS_PER_SB * SB_PER_LB) == 0) {
+                large_blocks.push_back(rank);
+            }
+            if (block_pos % BLOCKS_PER_SB == 0) {
+                small_blocks.push_back(uint16_t(rank - large_blocks.back()));
+            }
+            rank += count_in_block(block_pos, TRITS_PER_BLOCK);
+        }
+
+        // The unused trits in the last block are filled with 0s
+        if (Trit == 0) {
+            rank -= num_blocks * TRITS_PER_BLOCK - vec->get_num_trits();
+        }
+
+        m_large_blocks.steal(large_blocks);
+        m_small_blocks.steal(small_blocks);
+        m_num_target_trits = rank;
+    }
+
+    void set_vector(const packed_trit_vector<Packing>* vec) {
+        m_vec = vec;
+    }
+
+    // Returns the number of Trit between positions 0 and i-1.
+    uint64_t rank(const uint64_t i) const {
+        assert(m_vec != nullptr);
+        assert(i < m_vec->get_num_trits());
+
+        uint64_t rank = m_large_blocks[i / TRITS_PER_LB] + m_small_blocks[i / TRITS_PER_SB];
+
+        const uint64_t block_pos = i / TRITS_PER_BLOCK;
+        for (uint64_t b = block_pos / BLOCKS_PER_SB * BLOCKS_PER_SB; b < block_pos; ++b) {
+            rank += count_in_block(b, TRITS_PER_BLOCK);
+        }
+        const uint64_t k = i % TRITS_PER_BLOCK;
+        if (k != 0) {
+            rank += count_in_block(block_pos, k);
+        }
+        return rank;
+    }
+
+    // Returns the position of the (n+1)-th occurrence of Trit, for n < get_num_target_trits().
+    uint64_t select(uint64_t n) const {
+        assert(m_vec != nullptr);
+        assert(n < m_num_target_trits);
+
+        // (1) Search on Large Blocks
+        uint64_t left = 0;
+        uint64_t right = m_large_blocks.size();
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < m_large_blocks[center]) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+        n = n - m_large_blocks[left];
+
+        // (2) Search on Small Blocks
+        const uint64_t lb_pos = left;
+        left = lb_pos * SB_PER_LB;
+        right = std::min<uint64_t>(left + SB_PER_LB, m_small_blocks.size());
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < m_small_blocks[center]) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+        n = n - m_small_blocks[left] + 1;
+
+        // (3) Search on the blocks
+        uint64_t block_pos = left * BLOCKS_PER_SB;
+        for (;; ++block_pos) {
+            const uint64_t cnt = count_in_block(block_pos, TRITS_PER_BLOCK);
+            if (n <= cnt) {
+                break;
+            }
+            n = n - cnt;
+        }
+
+        // (4) Search on the trytes of the block
+        uint8_t trytes[TRYTES_PER_BLOCK];
+        m_vec->m_storage.decode(block_pos, trytes);
+
+        uint64_t j = 0;
+        for (;; ++j) {
+            const uint64_t cnt = get_tryte_count(trytes[j], get_num_trits_in_tryte(j));
+            if (n <= cnt) {
+                break;
+            }
+            n = n - cnt;
+        }
+        return block_pos * TRITS_PER_BLOCK + j * 5 + detail::tryte_luts<>::SELECT.table[Trit][n - 1][trytes[j]];
+    }
+
+    uint64_t get_num_trits() const {
+        return m_vec->get_num_trits();
+    }
+    uint64_t get_num_target_trits() const {
+        return m_num_target_trits;
+    }
+    uint64_t size_in_bytes() const {
+        return m_large_blocks.size() * sizeof(uint64_t) +  //
+               m_small_blocks.size() * sizeof(uint16_t) + sizeof(m_num_target_trits);
+    }
+
+    void save(std::ostream& os) const {
+        m_large_blocks.save(os);
+        m_small_blocks.save(os);
+        os.write(reinterpret_cast<const char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    void load(std::istream& is) {
+        m_large_blocks.load(is);
+        m_small_blocks.load(is);
+        is.read(reinterpret_cast<char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    const uint8_t* map(const uint8_t* ptr) {
+        ptr = m_large_blocks.map(ptr);
+        ptr = m_small_blocks.map(ptr);
+        std::memcpy(&m_num_target_trits, ptr, sizeof(m_num_target_trits));
+        return ptr + sizeof(m_num_target_trits);
+    }
+
+  private:
+    const packed_trit_vector<Packing>* m_vec = nullptr;
+    mappable_vector<uint64_t> m_large_blocks;
+    mappable_vector<uint16_t> m_small_blocks;
+    uint64_t m_num_target_trits = 0;
+
+    // Returns the number of trits in the j-th tryte of a block.
+    static uint64_t get_num_trits_in_tryte(uint64_t j) {
+        return std::min<uint64_t>(TRITS_PER_BLOCK - j * 5, 5);
+    }
+    // Returns the number of Trit in the first k trits of the tryte, for 0 < k <= 5.
+    static uint64_t get_tryte_count(uint8_t tryte, uint64_t k) {
+        const uint16_t cnt = detail::tryte_luts<>::FUSED.table[k - 1][tryte];
+        if (Trit == 0) {
+            return cnt & 0xFF;
+        } else if (Trit == 1) {
+            return cnt >> 8;
+        }
+        return k - (cnt & 0xFF) - (cnt >> 8);
+    }
+    // Returns the number of Trit in the first k trits of the block, for 0 < k <= TRITS_PER_BLOCK.
+    uint64_t count_in_block(uint64_t block_pos, uint64_t k) const {
+        uint8_t trytes[TRYTES_PER_BLOCK];
+        m_vec->m_storage.decode(block_pos, trytes);
+
+        uint64_t cnt = 0;
+        uint64_t j = 0;
+        for (; (j + 1) * 5 <= k; ++j) {
+            cnt += get_tryte_count(trytes[j], 5);
+        }
+        if (k % 5 != 0) {
+            cnt += get_tryte_count(trytes[j], k % 5);
+        }
+        return cnt;
+    }
+};
+
+}  // namespace succinctrits
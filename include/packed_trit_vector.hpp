@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "packing.hpp"
+#include "tryte_lut.hpp"
+
+namespace succinctrits {
+
+template <uint8_t, class>
+class packed_rs_support;
+
+// Trit vector whose packing is given by a policy in packing.hpp.
+// packed_trit_vector<tryte_packing> has the same layout as trit_vector.
+template <class Packing>
+class packed_trit_vector {
+  public:
+    static constexpr uint64_t TRITS_PER_BLOCK = Packing::TRITS_PER_BLOCK;
+
+    packed_trit_vector() = default;
+
+    template <class Iterator>
+    packed_trit_vector(Iterator it, uint64_t num_trits) {
+        build(it, num_trits);
+    }
+
+    template <class Iterator>
+    void build(Iterator it, uint64_t num_trits) {
+        m_storage = storage_type();
+        m_num_trits = num_trits;
+
+        // The unused trits in the last block are filled with 0s
+        uint8_t trits[TRITS_PER_BLOCK];
+        for (uint64_t i = 0; i < num_trits; i += TRITS_PER_BLOCK) {
+            for (uint64_t k = 0; k < TRITS_PER_BLOCK; ++k) {
+                if (i + k < num_trits) {
+                    assert(*it < 3);
+                    trits[k] = *it;
+                    ++it;
+                } else {
+                    trits[k] = 0;
+                }
+            }
+            m_storage.push_back(trits);
+        }
+        m_storage.finish();
+    }
+
+    uint8_t get(uint64_t i) const {
+        assert(i < m_num_trits);
+        const uint64_t k = i % TRITS_PER_BLOCK;
+        const uint8_t tryte = m_storage.get_tryte(i / TRITS_PER_BLOCK, k / 5);
+        return uint8_t(detail::tryte_luts<>::EXPAND.table[tryte] >> (k % 5 * 8));
+    }
+    uint8_t operator[](uint64_t i) const {
+        return get(i);
+    }
+
+    uint64_t get_num_trits() const {
+        return m_num_trits;
+    }
+    uint64_t size_in_bytes() const {
+        return m_storage.size_in_bytes() + sizeof(m_num_trits);
+    }
+
+    void save(std::ostream& os) const {
+        m_storage.save(os);
+        os.write(reinterpret_cast<const char*>(&m_num_trits), sizeof(uint64_t));
+    }
+    void load(std::istream& is) {
+        m_storage.load(is);
+        is.read(reinterpret_cast<char*>(&m_num_trits), sizeof(uint64_t));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    const uint8_t* map(const uint8_t* ptr) {
+        ptr = m_storage.map(ptr);
+        std::memcpy(&m_num_trits, ptr, sizeof(uint64_t));
+        return ptr + sizeof(uint64_t);
+    }
+
+  private:
+    using storage_type = typename Packing::storage;
+
+    storage_type m_storage;
+    uint64_t m_num_trits = 0;
+
+    template <uint8_t, class>
+    friend class packed_rs_support;
+};
+
+}  // namespace succinctrits
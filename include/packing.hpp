@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "mappable_vector.hpp"
+
+namespace succinctrits {
+
+// Packing policies of packed_trit_vector and packed_rs_support.
+//
+// A policy packs every TRITS_PER_BLOCK trits into a block, and decodes a block into TRYTES_PER_BLOCK
+// trytes (i.e., five trits in a byte as in trit_vector), so that the trits are counted with the
+// lookup tables on trytes. It also gives the shape of the Rank/Select directories in blocks.
+//
+// A policy has a nested class storage with the following members:
+//   void push_back(const uint8_t* trits)  : appends a block of trits[0..TRITS_PER_BLOCK)
+//   void finish()                          : called after the last push_back()
+//   uint8_t get_tryte(uint64_t block_pos, uint64_t j) const : the j-th tryte of the block
+//   void decode(uint64_t block_pos, uint8_t* trytes) const  : all the trytes of the block
+//   uint64_t size_in_bytes() const, save(), load() and map()
+
+// Five trits in a byte, i.e., 1.6 bits per trit, as in trit_vector.
+struct tryte_packing {
+    static constexpr uint64_t TRITS_PER_BLOCK = 5;
+    static constexpr uint64_t TRYTES_PER_BLOCK = 1;
+    static constexpr uint64_t BLOCKS_PER_SB = 10;  // 50 trits
+    static constexpr uint64_t SB_PER_LB = 1311;  // 65550 trits
+
+    static const char* name() {
+        return "tryte";
+    }
+
+    class storage {
+      public:
+        void push_back(const uint8_t* trits) {
+            m_buf.push_back(uint8_t(trits[0] + trits[1] * 3 + trits[2] * 9 + trits[3] * 27 + trits[4] * 81));
+        }
+        void finish() {
+            m_trytes.steal(m_buf);
+        }
+
+        uint8_t get_tryte(uint64_t block_pos, uint64_t) const {
+            return m_trytes[block_pos];
+        }
+        void decode(uint64_t block_pos, uint8_t* trytes) const {
+            trytes[0] = m_trytes[block_pos];
+        }
+
+        uint64_t size_in_bytes() const {
+            return m_trytes.size() * sizeof(uint8_t);
+        }
+        void save(std::ostream& os) const {
+            m_trytes.save(os);
+        }
+        void load(std::istream& is) {
+            m_trytes.load(is);
+        }
+        const uint8_t* map(const uint8_t* ptr) {
+            return m_trytes.map(ptr);
+        }
+
+      private:
+        std::vector<uint8_t> m_buf;
+        mappable_vector<uint8_t> m_trytes;
+    };
+};
+
+// 41 trits in 65 bits, i.e., about 1.5854 bits per trit, within 0.03% of log2(3).
+// A block is a number V < 3^41 < 2^65, whose lower 64 bits are kept in a word and the highest bit is
+// spilled into a separate bit array. It is decoded through V / 3^20 and V % 3^20 (i.e., 21 and 20
+// trits), which are computed with 64-bit arithmetic since V < 2^65.
+struct spill_packing {
+    static constexpr uint64_t TRITS_PER_BLOCK = 41;
+    static constexpr uint64_t TRYTES_PER_BLOCK = 9;  // the last one has a single trit
+    static constexpr uint64_t BLOCKS_PER_SB = 2;  // 82 trits
+    static constexpr uint64_t SB_PER_LB = 799;  // 65518 trits
+
+    static const char* name() {
+        return "spill";
+    }
+
+    class storage {
+      public:
+        void push_back(const uint8_t* trits) {
+            unsigned __int128 v = 0;
+            for (uint64_t k = TRITS_PER_BLOCK; k != 0; --k) {
+                v = v * 3 + trits[k - 1];
+            }
+            const uint64_t block_pos = m_words_buf.size();
+            m_words_buf.push_back(uint64_t(v));
+            if (block_pos % 64 == 0) {
+                m_spills_buf.push_back(0);
+            }
+            m_spills_buf.back() |= uint64_t(v >> 64) << (block_pos % 64);
+        }
+        void finish() {
+            m_words.steal(m_words_buf);
+            m_spills.steal(m_spills_buf);
+        }
+
+        uint8_t get_tryte(uint64_t block_pos, uint64_t j) const {
+            uint64_t q = 0, r = 0;
+            split(block_pos, q, r);
+            uint64_t x = j < 4 ? r : q;
+            for (uint64_t k = j < 4 ? j : j - 4; k != 0; --k) {
+                x /= 243;
+            }
+            return j == 8 ? uint8_t(x) : uint8_t(x % 243);
+        }
+        void decode(uint64_t block_pos, uint8_t* trytes) const {
+            uint64_t q = 0, r = 0;
+            split(block_pos, q, r);
+            for (uint64_t j = 0; j < 4; ++j) {
+                trytes[j] = uint8_t(r % 243);
+                r /= 243;
+            }
+            for (uint64_t j = 4; j < 8; ++j) {
+                trytes[j] = uint8_t(q % 243);
+                q /= 243;
+            }
+            trytes[8] = uint8_t(q);
+        }
+
+        uint64_t size_in_bytes() const {
+            return m_words.size() * sizeof(uint64_t) + m_spills.size() * sizeof(uint64_t);
+        }
+        void save(std::ostream& os) const {
+            m_words.save(os);
+            m_spills.save(os);
+        }
+        void load(std::istream& is) {
+            m_words.load(is);
+            m_spills.load(is);
+        }
+        const uint8_t* map(const uint8_t* ptr) {
+            ptr = m_words.map(ptr);
+            return m_spills.map(ptr);
+        }
+
+      private:
+        static constexpr uint64_t POW3_20 = 3486784401ULL;  // 3^20
+        // 2^64 = Q64 * 3^20 + R64
+        static constexpr uint64_t Q64 = UINT64_MAX / POW3_20 + (UINT64_MAX % POW3_20 + 1) / POW3_20;
+        static constexpr uint64_t R64 = (UINT64_MAX % POW3_20 + 1) % POW3_20;
+
+        std::vector<uint64_t> m_words_buf;
+        std::vector<uint64_t> m_spills_buf;
+        mappable_vector<uint64_t> m_words;  // lower 64 bits of the blocks
+        mappable_vector<uint64_t> m_spills;  // highest bits of the blocks
+
+        // Computes q = V / 3^20 and r = V % 3^20 for the block V.
+        void split(uint64_t block_pos, uint64_t& q, uint64_t& r) const {
+            const uint64_t lo = m_words[block_pos];
+            q = lo / POW3_20;
+            r = lo % POW3_20;
+            // Branch-free since the spilled bits are unpredictable
+            const uint64_t hi = m_spills[block_pos / 64] >> (block_pos % 64) & 1;
+            q += hi * Q64;
+            r += hi * R64;
+            const uint64_t carry = POW3_20 <= r;
+            q += carry;
+            r -= carry * POW3_20;
+        }
+    };
+};
+
+}  // namespace succinctrits
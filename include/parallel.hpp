@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace succinctrits {
+namespace detail {
+
+// Splits [0, num_items) into num_threads contiguous ranges and calls func(beg, end) for each of
+// them in parallel. The first range is processed by the calling thread.
+template <class Func>
+void parallel_for(uint64_t num_items, uint64_t num_threads, Func func) {
+    assert(num_threads != 0);
+
+    num_threads = std::max<uint64_t>(1, std::min(num_threads, num_items));
+    const uint64_t chunk = (num_items + num_threads - 1) / num_threads;
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (uint64_t t = 1; t < num_threads; ++t) {
+        const uint64_t beg = std::min(t * chunk, num_items);
+        const uint64_t end = std::min(beg + chunk, num_items);
+        threads.emplace_back(func, beg, end);
+    }
+    func(0, std::min(chunk, num_items));
+
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+}  // namespace detail
+}  // namespace succinctrits
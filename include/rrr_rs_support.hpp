@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "mappable_vector.hpp"
+#include "rrr_trit_vector.hpp"
+
+namespace succinctrits {
+
+// Rank/Select support on rrr_trit_vector with the same interface as rs_support.
+//
+// The counts of Trit are sampled at the same positions as the offsets of the vector, and the blocks
+// after a sample are counted from their classes. Only the block including the answer is decoded.
+template <uint8_t Trit>
+class rrr_rs_support {
+  public:
+    static_assert(Trit < 3, "");
+
+  private:
+    static constexpr uint64_t BLOCK_SIZE = rrr_trit_vector::BLOCK_SIZE;
+    static constexpr uint64_t BLOCKS_PER_SAMPLE = rrr_trit_vector::BLOCKS_PER_SAMPLE;
+
+  public:
+    rrr_rs_support() = default;
+
+    explicit rrr_rs_support(const rrr_trit_vector* vec) {
+        build(vec);
+    }
+
+    void build(const rrr_trit_vector* vec) {
+        m_vec = vec;
+
+        const uint64_t num_blocks = (vec->get_num_trits() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        std::vector<uint64_t> ranks;
+        ranks.reserve(num_blocks / BLOCKS_PER_SAMPLE + 1);
+
+        uint64_t rank = 0;
+        for (uint64_t block_pos = 0; block_pos < num_blocks; ++block_pos) {
+            if (block_pos % BLOCKS_PER_SAMPLE == 0) {
+                ranks.push_back(rank);
+            }
+            rank += rrr_trit_vector::get_count(vec->get_class(block_pos), Trit);
+        }
+
+        // The unused trits in the last block are filled with 0s
+        if (Trit == 0) {
+            rank -= num_blocks * BLOCK_SIZE - vec->get_num_trits();
+        }
+
+        m_ranks.steal(ranks);
+        m_num_target_trits = rank;
+    }
+
+    void set_vector(const rrr_trit_vector* vec) {
+        m_vec = vec;
+    }
+
+    // Returns the number of Trit between positions 0 and i-1.
+    uint64_t rank(const uint64_t i) const {
+        assert(m_vec != nullptr);
+        assert(i < m_vec->get_num_trits());
+
+        const uint64_t block_pos = i / BLOCK_SIZE;
+        const uint64_t sample_pos = block_pos / BLOCKS_PER_SAMPLE;
+        uint64_t rank = m_ranks[sample_pos];
+        uint64_t offset_pos = m_vec->m_samples[sample_pos];
+
+        for (uint64_t b = sample_pos * BLOCKS_PER_SAMPLE; b < block_pos; ++b) {
+            const uint64_t cls = m_vec->get_class(b);
+            rank += rrr_trit_vector::get_count(cls, Trit);
+            offset_pos += rrr_trit_vector::get_lut().width[cls >> 5][cls & 31];
+        }
+
+        const uint64_t k = i % BLOCK_SIZE;
+        if (k != 0) {
+            const uint64_t cls = m_vec->get_class(block_pos);
+            if (rrr_trit_vector::get_count(cls, Trit) != 0) {
+                uint8_t trits[BLOCK_SIZE];
+                m_vec->decode_block(block_pos, cls, offset_pos, k, trits);
+                for (uint64_t j = 0; j < k; ++j) {
+                    rank += trits[j] == Trit;
+                }
+            }
+        }
+        return rank;
+    }
+
+    // Returns the position of the (n+1)-th occurrence of Trit, for n < get_num_target_trits().
+    uint64_t select(uint64_t n) const {
+        assert(m_vec != nullptr);
+        assert(n < m_num_target_trits);
+
+        // (1) Search on the samples
+        uint64_t left = 0;
+        uint64_t right = m_ranks.size();
+
+        while (left + 1 < right) {
+            const uint64_t center = (left + right) / 2;
+            if (n < m_ranks[center]) {
+                right = center;
+            } else {
+                left = center;
+            }
+        }
+        n = n - m_ranks[left];
+
+        // (2) Search on the classes of the blocks
+        uint64_t block_pos = left * BLOCKS_PER_SAMPLE;
+        uint64_t offset_pos = m_vec->m_samples[left];
+        uint64_t cls = 0;
+        for (;; ++block_pos) {
+            cls = m_vec->get_class(block_pos);
+            const uint64_t cnt = rrr_trit_vector::get_count(cls, Trit);
+            if (n < cnt) {
+                break;
+            }
+            n = n - cnt;
+            offset_pos += rrr_trit_vector::get_lut().width[cls >> 5][cls & 31];
+        }
+
+        // (3) Search on the decoded block
+        uint8_t trits[BLOCK_SIZE];
+        m_vec->decode_block(block_pos, cls, offset_pos, BLOCK_SIZE, trits);
+        uint64_t j = 0;
+        for (;; ++j) {
+            if (trits[j] == Trit) {
+                if (n == 0) {
+                    break;
+                }
+                --n;
+            }
+        }
+        return block_pos * BLOCK_SIZE + j;
+    }
+
+    uint64_t get_num_trits() const {
+        return m_vec->get_num_trits();
+    }
+    uint64_t get_num_target_trits() const {
+        return m_num_target_trits;
+    }
+    uint64_t size_in_bytes() const {
+        return m_ranks.size() * sizeof(uint64_t) + sizeof(m_num_target_trits);
+    }
+
+    void save(std::ostream& os) const {
+        m_ranks.save(os);
+        os.write(reinterpret_cast<const char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    void load(std::istream& is) {
+        m_ranks.load(is);
+        is.read(reinterpret_cast<char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    const uint8_t* map(const uint8_t* ptr) {
+        ptr = m_ranks.map(ptr);
+        std::memcpy(&m_num_target_trits, ptr, sizeof(m_num_target_trits));
+        return ptr + sizeof(m_num_target_trits);
+    }
+
+  private:
+    const rrr_trit_vector* m_vec = nullptr;
+    mappable_vector<uint64_t> m_ranks;  // counts of Trit before every sample
+    uint64_t m_num_target_trits = 0;
+};
+
+}  // namespace succinctrits
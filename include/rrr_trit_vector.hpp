@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "mappable_vector.hpp"
+
+namespace succinctrits {
+
+template <uint8_t>
+class rrr_rs_support;
+
+namespace detail {
+
+// Lookup tables of rrr_trit_vector generated at compile time.
+// BINOM[n][k] holds n choose k, and WIDTH[c0][c1] holds the number of bits for the offsets of the
+// blocks of class (c0, c1), i.e., ceil(log2(multinomial(b; c0, c1, b - c0 - c1))).
+template <uint64_t BlockSize>
+struct rrr_lut_type {
+    uint64_t binom[BlockSize + 1][BlockSize + 1];
+    uint8_t width[BlockSize + 1][BlockSize + 1];
+};
+
+template <uint64_t BlockSize>
+constexpr rrr_lut_type<BlockSize> make_rrr_lut() {
+    rrr_lut_type<BlockSize> lut{};
+    for (uint64_t n = 0; n <= BlockSize; ++n) {
+        lut.binom[n][0] = 1;
+        for (uint64_t k = 1; k <= n; ++k) {
+            lut.binom[n][k] = lut.binom[n - 1][k - 1] + (k < n ? lut.binom[n - 1][k] : 0);
+        }
+    }
+    for (uint64_t c0 = 0; c0 <= BlockSize; ++c0) {
+        for (uint64_t c1 = 0; c0 + c1 <= BlockSize; ++c1) {
+            const uint64_t m = lut.binom[BlockSize][c0] * lut.binom[BlockSize - c0][c1];
+            uint8_t w = 0;
+            while (w < 64 && (uint64_t(1) << w) < m) {
+                ++w;
+            }
+            lut.width[c0][c1] = w;
+        }
+    }
+    return lut;
+}
+
+// The table is kept as a static member of a class template so that it is defined only once.
+template <uint64_t BlockSize>
+struct rrr_luts {
+    static constexpr rrr_lut_type<BlockSize> LUT = make_rrr_lut<BlockSize>();
+};
+
+template <uint64_t BlockSize>
+constexpr rrr_lut_type<BlockSize> rrr_luts<BlockSize>::LUT;
+
+}  // namespace detail
+
+// Compressed trit vector for skewed distributions, in the manner of RRR (Raman, Raman and Rao).
+//
+// Every block of BLOCK_SIZE trits is stored as its class, i.e., the counts of 0s and 1s in CLASS_BITS
+// bits, and its offset, i.e., the rank of the block among all the blocks of the class in as many bits
+// as the class needs. Blocks with few distinct arrangements, e.g., almost all 0s, take few bits.
+// The position of the offsets is sampled every BLOCKS_PER_SAMPLE blocks.
+class rrr_trit_vector {
+  public:
+    static constexpr uint64_t BLOCK_SIZE = 31;  // 3^31 < 2^50
+    static constexpr uint64_t BLOCKS_PER_SAMPLE = 32;  // 992 trits
+    static constexpr uint64_t TRITS_PER_SAMPLE = BLOCK_SIZE * BLOCKS_PER_SAMPLE;
+
+  private:
+    static constexpr uint64_t CLASS_BITS = 10;  // 5 bits for each count
+
+  public:
+    rrr_trit_vector() = default;
+
+    template <class Iterator>
+    rrr_trit_vector(Iterator it, uint64_t num_trits) {
+        build(it, num_trits);
+    }
+
+    template <class Iterator>
+    void build(Iterator it, uint64_t num_trits) {
+        const uint64_t num_blocks = (num_trits + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        std::vector<uint64_t> classes;
+        std::vector<uint64_t> offsets;
+        std::vector<uint64_t> samples;
+        uint64_t num_class_bits = 0;
+        uint64_t num_offset_bits = 0;
+
+        // The unused trits in the last block are filled with 0s
+        uint8_t trits[BLOCK_SIZE];
+        for (uint64_t block_pos = 0; block_pos < num_blocks; ++block_pos) {
+            uint64_t c0 = 0, c1 = 0;
+            for (uint64_t k = 0; k < BLOCK_SIZE; ++k) {
+                if (block_pos * BLOCK_SIZE + k < num_trits) {
+                    assert(*it < 3);
+                    trits[k] = *it;
+                    ++it;
+                } else {
+                    trits[k] = 0;
+                }
+                c0 += trits[k] == 0;
+                c1 += trits[k] == 1;
+            }
+            if (block_pos % BLOCKS_PER_SAMPLE == 0) {
+                samples.push_back(num_offset_bits);
+            }
+            append_bits(classes, num_class_bits, c0 << 5 | c1, CLASS_BITS);
+            append_bits(offsets, num_offset_bits, encode_block(trits, c0, c1), get_lut().width[c0][c1]);
+        }
+
+        // A padding word so that get_bits() can always read two words
+        classes.push_back(0);
+        offsets.push_back(0);
+
+        m_classes.steal(classes);
+        m_offsets.steal(offsets);
+        m_samples.steal(samples);
+        m_num_trits = num_trits;
+    }
+
+    uint8_t get(uint64_t i) const {
+        assert(i < m_num_trits);
+        uint8_t trits[BLOCK_SIZE];
+        decode_block(i / BLOCK_SIZE, i % BLOCK_SIZE + 1, trits);
+        return trits[i % BLOCK_SIZE];
+    }
+    uint8_t operator[](uint64_t i) const {
+        return get(i);
+    }
+
+    uint64_t get_num_trits() const {
+        return m_num_trits;
+    }
+    uint64_t size_in_bytes() const {
+        return m_classes.size() * sizeof(uint64_t) +  //
+               m_offsets.size() * sizeof(uint64_t) +  //
+               m_samples.size() * sizeof(uint64_t) + sizeof(m_num_trits);
+    }
+
+    void save(std::ostream& os) const {
+        m_classes.save(os);
+        m_offsets.save(os);
+        m_samples.save(os);
+        os.write(reinterpret_cast<const char*>(&m_num_trits), sizeof(m_num_trits));
+    }
+    void load(std::istream& is) {
+        m_classes.load(is);
+        m_offsets.load(is);
+        m_samples.load(is);
+        is.read(reinterpret_cast<char*>(&m_num_trits), sizeof(m_num_trits));
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    const uint8_t* map(const uint8_t* ptr) {
+        ptr = m_classes.map(ptr);
+        ptr = m_offsets.map(ptr);
+        ptr = m_samples.map(ptr);
+        std::memcpy(&m_num_trits, ptr, sizeof(m_num_trits));
+        return ptr + sizeof(m_num_trits);
+    }
+
+  private:
+    mappable_vector<uint64_t> m_classes;  // CLASS_BITS bits per block
+    mappable_vector<uint64_t> m_offsets;  // variable-length offsets
+    mappable_vector<uint64_t> m_samples;  // bit positions of the offsets of every BLOCKS_PER_SAMPLE-th block
+    uint64_t m_num_trits = 0;
+
+    static const detail::rrr_lut_type<BLOCK_SIZE>& get_lut() {
+        return detail::rrr_luts<BLOCK_SIZE>::LUT;
+    }
+
+    // Returns the number of the blocks with c0 0s, c1 1s and c2 2s.
+    static uint64_t get_multinomial(uint64_t c0, uint64_t c1, uint64_t c2) {
+        return get_lut().binom[c0 + c1 + c2][c0] * get_lut().binom[c1 + c2][c1];
+    }
+
+    static void append_bits(std::vector<uint64_t>& words, uint64_t& num_bits, uint64_t x, uint64_t width) {
+        if (width == 0) {
+            return;
+        }
+        const uint64_t shift = num_bits % 64;
+        if (shift == 0) {
+            words.push_back(0);
+        }
+        words.back() |= x << shift;
+        if (shift + width > 64) {
+            words.push_back(x >> (64 - shift));
+        }
+        num_bits += width;
+    }
+    static uint64_t get_bits(const uint64_t* words, uint64_t pos, uint64_t width) {
+        if (width == 0) {
+            return 0;
+        }
+        const uint64_t shift = pos % 64;
+        uint64_t x = words[pos / 64] >> shift;
+        if (shift + width > 64) {
+            x |= words[pos / 64 + 1] << (64 - shift);
+        }
+        return width == 64 ? x : x & ((uint64_t(1) << width) - 1);
+    }
+
+    // Returns the rank of the block among the blocks of the same class in lexicographic order.
+    static uint64_t encode_block(const uint8_t* trits, uint64_t c0, uint64_t c1) {
+        uint64_t c2 = BLOCK_SIZE - c0 - c1;
+        uint64_t offset = 0;
+        for (uint64_t k = 0; k < BLOCK_SIZE; ++k) {
+            if (trits[k] == 0) {
+                --c0;
+                continue;
+            }
+            if (c0 != 0) {
+                offset += get_multinomial(c0 - 1, c1, c2);
+            }
+            if (trits[k] == 1) {
+                --c1;
+                continue;
+            }
+            if (c1 != 0) {
+                offset += get_multinomial(c0, c1 - 1, c2);
+            }
+            --c2;
+        }
+        return offset;
+    }
+
+    uint64_t get_class(uint64_t block_pos) const {
+        return get_bits(m_classes.data(), block_pos * CLASS_BITS, CLASS_BITS);
+    }
+    static uint64_t get_count(uint64_t cls, uint8_t trit) {
+        const uint64_t c0 = cls >> 5, c1 = cls & 31;
+        return trit == 0 ? c0 : (trit == 1 ? c1 : BLOCK_SIZE - c0 - c1);
+    }
+
+    // Returns the bit position of the offset of the block.
+    uint64_t get_offset_pos(uint64_t block_pos) const {
+        uint64_t pos = m_samples[block_pos / BLOCKS_PER_SAMPLE];
+        for (uint64_t b = block_pos / BLOCKS_PER_SAMPLE * BLOCKS_PER_SAMPLE; b < block_pos; ++b) {
+            const uint64_t cls = get_class(b);
+            pos += get_lut().width[cls >> 5][cls & 31];
+        }
+        return pos;
+    }
+
+    // Decodes the first num trits of the block into trits[0..num).
+    void decode_block(uint64_t block_pos, uint64_t num, uint8_t* trits) const {
+        decode_block(block_pos, get_class(block_pos), get_offset_pos(block_pos), num, trits);
+    }
+    void decode_block(uint64_t block_pos, uint64_t cls, uint64_t offset_pos, uint64_t num, uint8_t* trits) const {
+        assert(block_pos < (m_num_trits + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+        uint64_t c0 = cls >> 5, c1 = cls & 31;
+        uint64_t c2 = BLOCK_SIZE - c0 - c1;
+        uint64_t offset = get_bits(m_offsets.data(), offset_pos, get_lut().width[c0][c1]);
+
+        for (uint64_t k = 0; k < num; ++k) {
+            // The remaining trits are the same if there is only one arrangement
+            if (c1 == 0 && c2 == 0) {
+                std::memset(trits + k, 0, num - k);
+                return;
+            }
+            if (c0 != 0) {
+                const uint64_t m = get_multinomial(c0 - 1, c1, c2);
+                if (offset < m) {
+                    trits[k] = 0;
+                    --c0;
+                    continue;
+                }
+                offset -= m;
+            }
+            if (c1 != 0) {
+                const uint64_t m = get_multinomial(c0, c1 - 1, c2);
+                if (offset < m) {
+                    trits[k] = 1;
+                    --c1;
+                    continue;
+                }
+                offset -= m;
+            }
+            trits[k] = 2;
+            --c2;
+        }
+    }
+
+    template <uint8_t>
+    friend class rrr_rs_support;
+};
+
+}  // namespace succinctrits
@@ -2,58 +2,238 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
+#include "elias_fano.hpp"
+#include "mappable_vector.hpp"
+#include "parallel.hpp"
+#include "stats.hpp"
 #include "trit_vector.hpp"
+#include "tryte_lut.hpp"
+#include "tryte_simd.hpp"
 
 namespace succinctrits {
 
-template <uint8_t Trit>
+class streaming_builder;
+
+namespace detail {
+
+// Large and small block counts of the three trits, computed in parallel on the large blocks.
+// As in rs_support::build(), the counts of 0s include the unused trits in the last tryte.
+template <uint64_t TritsPerLB, uint64_t TritsPerSB, class Counter = uint16_t>
+struct rank_directories {
+    static constexpr uint64_t TRYTES_PER_LB = TritsPerLB / trit_vector::TRITS_PER_BYTE;
+    static constexpr uint64_t TRYTES_PER_SB = TritsPerSB / trit_vector::TRITS_PER_BYTE;
+    static_assert(TritsPerSB < 256, "the counts of a small block are summed up in bytes");
+
+    std::vector<uint64_t> large_blocks[3];
+    std::vector<Counter> small_blocks[3];
+    uint64_t num_target_trits[3] = {0, 0, 0};
+
+    // Only the trits in the bit mask targets are stored.
+    rank_directories(const uint8_t* trytes, uint64_t num_trytes, uint32_t targets, uint64_t num_threads) {
+        const uint64_t num_lbs = (num_trytes + TRYTES_PER_LB - 1) / TRYTES_PER_LB;
+        const uint64_t num_sbs = (num_trytes + TRYTES_PER_SB - 1) / TRYTES_PER_SB;
+        for (uint32_t t = 0; t < 3; ++t) {
+            if (targets >> t & 1) {
+                large_blocks[t].resize(num_lbs);
+                small_blocks[t].resize(num_sbs);
+            }
+        }
+
+        // Each thread fills the small blocks of its own large blocks, and puts the totals of the
+        // large blocks in large_blocks, which are turned into the prefix sums afterward.
+        parallel_for(num_lbs, num_threads, [&](uint64_t lb_beg, uint64_t lb_end) {
+            for (uint64_t lb_pos = lb_beg; lb_pos < lb_end; ++lb_pos) {
+                const uint64_t tryte_end = std::min(lb_pos * TRYTES_PER_LB + TRYTES_PER_LB, num_trytes);
+                uint64_t ranks[3] = {0, 0, 0};
+
+                for (uint64_t i = lb_pos * TRYTES_PER_LB; i < tryte_end; i += TRYTES_PER_SB) {
+                    for (uint32_t t = 0; t < 3; ++t) {
+                        if (targets >> t & 1) {
+                            assert(ranks[t] <= std::numeric_limits<Counter>::max());
+                            small_blocks[t][i / TRYTES_PER_SB] = Counter(ranks[t]);
+                        }
+                    }
+                    const uint64_t sb_end = std::min(i + TRYTES_PER_SB, tryte_end);
+                    uint16_t cnt = 0;
+                    for (uint64_t j = i; j < sb_end; ++j) {
+                        cnt += tryte_luts<>::FUSED.table[4][trytes[j]];
+                    }
+                    ranks[0] += cnt & 0xFF;
+                    ranks[1] += cnt >> 8;
+                    ranks[2] += (sb_end - i) * trit_vector::TRITS_PER_BYTE - (cnt & 0xFF) - (cnt >> 8);
+                }
+                for (uint32_t t = 0; t < 3; ++t) {
+                    if (targets >> t & 1) {
+                        large_blocks[t][lb_pos] = ranks[t];
+                    }
+                }
+            }
+        });
+
+        for (uint32_t t = 0; t < 3; ++t) {
+            uint64_t rank = 0;
+            for (uint64_t& lb : large_blocks[t]) {
+                const uint64_t cnt = lb;
+                lb = rank;
+                rank += cnt;
+            }
+            num_target_trits[t] = rank;
+        }
+    }
+};
+
+}  // namespace detail
+
+// Layout of rs_support.
+//  - dense: counters on large and small blocks, taking about 0.32 bits per trit.
+//  - sparse: the positions of the target trit in Elias-Fano, taking about 2 + log2(1 / density) bits
+//    per occurrence. Select takes constant time, and rank searches a few positions.
+//  - automatic: sparse if the target trit appears at most once in SPARSE_DENSITY trits, or dense.
+enum class rs_layout : uint64_t {
+    dense = 0,
+    sparse = 1,
+    automatic = 2,
+};
+
+// The block parameters are given by TritsPerLB and TritsPerSB, and the small blocks keep the counts
+// relative to the large blocks in Counter. The defaults take 0.32 bits per trit, e.g.,
+//  - rs_support<Trit, 65500, 100> takes 0.16 bits per trit but scans twice the trytes, and
+//  - rs_support<Trit, 250, 25, uint8_t> scans half the trytes of the defaults in 0.58 bits per trit.
+template <uint8_t Trit, uint64_t TritsPerLB, uint64_t TritsPerSB, class Counter>
 class rs_support {
-  private:
+  public:
     static_assert(Trit < 3, "");
+    static_assert(TritsPerSB != 0 && TritsPerSB % trit_vector::TRITS_PER_BYTE == 0,
+                  "a small block must consist of whole trytes");
+    static_assert(TritsPerLB % TritsPerSB == 0, "a large block must consist of whole small blocks");
+    static_assert(std::is_unsigned<Counter>::value && TritsPerLB - TritsPerSB <= std::numeric_limits<Counter>::max(),
+                  "the counts of small blocks must fit in Counter");
+
+    static constexpr uint64_t TRITS_PER_LB = TritsPerLB;
+    static constexpr uint64_t TRITS_PER_SB = TritsPerSB;
 
-    static constexpr uint64_t TRITS_PER_LB = 65550;
-    static constexpr uint64_t TRITS_PER_SB = 50;
+    // rs_layout::automatic chooses the sparse layout if the density of the target trit is at most
+    // 1 / SPARSE_DENSITY, where it takes less than half the space of the dense one.
+    static constexpr uint64_t SPARSE_DENSITY = 64;
 
+  private:
     static constexpr uint64_t TRITS_PER_BYTE = trit_vector::TRITS_PER_BYTE;
-    static constexpr uint64_t TRYTES_PER_LB = TRITS_PER_LB / TRITS_PER_BYTE;  // 13110 trytes
-    static constexpr uint64_t TRYTES_PER_SB = TRITS_PER_SB / TRITS_PER_BYTE;  // 10 trytes
-    static constexpr uint64_t LB_PER_SB = TRITS_PER_LB / TRITS_PER_SB;  // 1311
+    static constexpr uint64_t TRYTES_PER_LB = TRITS_PER_LB / TRITS_PER_BYTE;  // 13110 trytes by default
+    static constexpr uint64_t TRYTES_PER_SB = TRITS_PER_SB / TRITS_PER_BYTE;  // 10 trytes by default
+    static constexpr uint64_t LB_PER_SB = TRITS_PER_LB / TRITS_PER_SB;  // 1311 by default
+
+    // The SIMD kernels scan a small block within 16 trytes, and the linear search of small blocks
+    // works on 16-bit counters.
+    static constexpr bool SIMD_SCAN = TRYTES_PER_SB <= 16;
+    static constexpr bool SIMD_SB_SEARCH = std::is_same<Counter, uint16_t>::value;
+
+    // Small blocks are searched linearly in select if the candidates are no more than this.
+    static constexpr uint64_t SB_LINEAR_SEARCH_LIMIT = 64;
+
+    // Parameters of the batched queries
+    static constexpr uint64_t PREFETCH_DISTANCE = 16;
+    static constexpr uint64_t SELECT_BATCH_SIZE = 32;
+
+    // next() and prev() scan this number of trytes before falling back to rank and select.
+    static constexpr uint64_t NEAR_SCAN_TRYTES = 16;
 
   public:
     rs_support() = default;
 
-    explicit rs_support(const trit_vector* vec) {
-        build(vec);
+    // If select_sample_rate is not zero, the position of every select_sample_rate-th occurrence of
+    // the target trit is sampled to speed up select.
+    // e.g., select_sample_rate = 512 takes about 0.05 bits per trit for uniformly random trits.
+    explicit rs_support(const trit_vector* vec, uint64_t select_sample_rate = 0) {
+        build(vec, select_sample_rate);
+    }
+
+    // select_sample_rate is ignored in the sparse layout.
+    rs_support(const trit_vector* vec, rs_layout layout, uint64_t select_sample_rate = 0) {
+        build(vec, layout, select_sample_rate);
     }
 
-    void build(const trit_vector* vec) {
+    void build(const trit_vector* vec, uint64_t select_sample_rate = 0) {
         m_vec = vec;
-        m_large_blocks.clear();
-        m_small_blocks.clear();
-        m_large_blocks.reserve(m_vec->m_trytes.size() / TRYTES_PER_LB + 1);
-        m_small_blocks.reserve(m_vec->m_trytes.size() / TRYTES_PER_SB + 1);
+        m_layout = rs_layout::dense;
+        m_positions = elias_fano();
+
+        std::vector<uint64_t> large_blocks;
+        std::vector<Counter> small_blocks;
+        large_blocks.reserve(m_vec->m_trytes.size() / TRYTES_PER_LB + 1);
+        small_blocks.reserve(m_vec->m_trytes.size() / TRYTES_PER_SB + 1);
 
         uint64_t rank = 0;
         for (uint64_t i = 0; i < m_vec->m_trytes.size(); ++i) {
             if (i % TRYTES_PER_LB == 0) {
-                m_large_blocks.push_back(rank);
+                large_blocks.push_back(rank);
             }
             if (i % TRYTES_PER_SB == 0) {
-                assert(rank - m_large_blocks.back() <= UINT16_MAX);
-                m_small_blocks.push_back(uint16_t(rank - m_large_blocks.back()));
+                assert(rank - large_blocks.back() <= std::numeric_limits<Counter>::max());
+                small_blocks.push_back(Counter(rank - large_blocks.back()));
             }
             rank += LUT[4][m_vec->m_trytes[i]];
         }
+        m_large_blocks.steal(large_blocks);
+        m_small_blocks.steal(small_blocks);
+
+        if (Trit == 0) {
+            // The unused trits in the last tryte are filled with 0s
+            rank -= m_vec->m_trytes.size() * TRITS_PER_BYTE - m_vec->get_num_trits();
+        }
         m_num_target_trits = rank;
+
+        build_select_samples(select_sample_rate);
+    }
+
+    void build(const trit_vector* vec, rs_layout layout, uint64_t select_sample_rate = 0) {
+        if (layout == rs_layout::automatic) {
+            uint64_t num_target_trits = 0;
+            for (uint64_t i = 0; i < vec->m_trytes.size(); ++i) {
+                num_target_trits += LUT[4][vec->m_trytes[i]];
+            }
+            if (Trit == 0) {
+                num_target_trits -= vec->m_trytes.size() * TRITS_PER_BYTE - vec->get_num_trits();
+            }
+            layout = num_target_trits * SPARSE_DENSITY <= vec->get_num_trits() ? rs_layout::sparse : rs_layout::dense;
+        }
+        if (layout == rs_layout::dense) {
+            build(vec, select_sample_rate);
+        } else {
+            build_sparse(vec);
+        }
+    }
+
+    // Builds the index with num_threads threads, each of which takes a range of large blocks.
+    // The result is identical to build(vec, select_sample_rate).
+    // To build the indexes of several trits in a single pass, use build_rs_supports().
+    void build(const trit_vector* vec, uint64_t select_sample_rate, uint64_t num_threads) {
+        directories_type dirs(vec->m_trytes.data(), vec->m_trytes.size(), 1U << Trit, num_threads);
+        build(vec, dirs, select_sample_rate);
     }
 
     void set_vector(const trit_vector* vec) {
         m_vec = vec;
     }
 
+    // Moves the directories into memory from resource, which must outlive this object.
+    void relocate(memory_resource* resource) {
+        m_large_blocks.relocate(resource);
+        m_small_blocks.relocate(resource);
+        m_select_samples.relocate(resource);
+        m_positions.relocate(resource);
+    }
+
+    // Returns rs_layout::dense or rs_layout::sparse.
+    rs_layout get_layout() const {
+        return m_layout;
+    }
+
     uint8_t get(uint64_t i) const {
         assert(m_vec != nullptr);
         return m_vec->get(i);
@@ -63,9 +243,280 @@ class rs_support {
     }
 
     // Returns the number of occurrences of the target trits in m_vec between positions 0 and i-1.
+    // The SIMD kernels of the ISA chosen at runtime are used if any (see get_isa()).
     uint64_t rank(const uint64_t i) const {
+        return rank_impl<true>(i);
+    }
+    // Same as rank() but always uses the scalar scan on trytes.
+    uint64_t rank_scalar(const uint64_t i) const {
+        return rank_impl<false>(i);
+    }
+
+    // Returns the position of the (n+1)-th occurrence of the target trit in m_vec.
+    uint64_t select(uint64_t n) const {
+        return select_impl<true>(n);
+    }
+    // Same as select() but always uses the scalar scan on trytes.
+    uint64_t select_scalar(uint64_t n) const {
+        return select_impl<false>(n);
+    }
+
+    // Computes ranks[j] = rank(positions[j]) for 0 <= j < num.
+    // The memory accesses of following queries are prefetched to overlap the cache misses.
+    void rank_batch(const uint64_t* positions, uint64_t num, uint64_t* ranks) const {
+        if (m_layout == rs_layout::sparse) {
+            for (uint64_t j = 0; j < num; ++j) {
+                ranks[j] = m_positions.rank(positions[j]);
+            }
+            return;
+        }
+        for (uint64_t j = 0; j < num; ++j) {
+            if (j + PREFETCH_DISTANCE < num) {
+                // Unlike select, every address to be accessed is known from the position.
+                // The large blocks are not prefetched since they are small enough to stay in cache.
+                const uint64_t i = positions[j + PREFETCH_DISTANCE];
+                __builtin_prefetch(m_small_blocks.data() + i / TRITS_PER_SB);
+                __builtin_prefetch(m_vec->m_trytes.data() + i / TRITS_PER_SB * TRYTES_PER_SB);
+            }
+            ranks[j] = rank(positions[j]);
+        }
+    }
+
+    // Computes positions[j] = select(ns[j]) for 0 <= j < num.
+    // The binary searches of SELECT_BATCH_SIZE queries are interleaved step by step, and the next
+    // probes of all the queries are prefetched at each step to overlap the cache misses.
+    void select_batch(const uint64_t* ns, uint64_t num, uint64_t* positions) const {
+        assert(m_vec != nullptr);
+        SUCCINCTRITS_STATS_ADD(num_select, num);  // the steps of the interleaved searches are not counted
+
+        if (m_layout == rs_layout::sparse) {
+            for (uint64_t j = 0; j < num; ++j) {
+                positions[j] = m_positions.select(ns[j]);
+            }
+            return;
+        }
+
+        uint64_t xs[SELECT_BATCH_SIZE];
+        uint64_t lefts[SELECT_BATCH_SIZE];
+        uint64_t rights[SELECT_BATCH_SIZE];
+        uint64_t sb_lefts[SELECT_BATCH_SIZE];
+        uint64_t sb_rights[SELECT_BATCH_SIZE];
+
+        for (uint64_t beg = 0; beg < num; beg += SELECT_BATCH_SIZE) {
+            const uint64_t size = std::min<uint64_t>(num - beg, uint64_t(SELECT_BATCH_SIZE));
+
+            // (1) Search on Large Blocks
+            for (uint64_t j = 0; j < size; ++j) {
+                xs[j] = ns[beg + j];
+                assert(xs[j] < m_num_target_trits);
+                get_sb_candidates(xs[j], sb_lefts[j], sb_rights[j]);
+                lefts[j] = sb_lefts[j] / LB_PER_SB;
+                rights[j] = (sb_rights[j] - 1) / LB_PER_SB + 1;
+            }
+            interleaved_search(m_large_blocks.data(), size, xs, lefts, rights);
+
+            // (2) Search on Small Blocks
+            for (uint64_t j = 0; j < size; ++j) {
+                const uint64_t lb_pos = lefts[j];
+                xs[j] = xs[j] - m_large_blocks[lb_pos];
+                lefts[j] = std::max<uint64_t>(lb_pos * LB_PER_SB, sb_lefts[j]);
+                rights[j] = std::min<uint64_t>({lb_pos * LB_PER_SB + LB_PER_SB, sb_rights[j], m_small_blocks.size()});
+            }
+            interleaved_search(m_small_blocks.data(), size, xs, lefts, rights);
+
+            // (3) Search on the remaining trytes
+            for (uint64_t j = 0; j < size; ++j) {
+                __builtin_prefetch(m_vec->m_trytes.data() + lefts[j] * TRYTES_PER_SB);
+            }
+            for (uint64_t j = 0; j < size; ++j) {
+                positions[beg + j] = select_in_sb<true>(lefts[j], xs[j] - m_small_blocks[lefts[j]]);
+            }
+        }
+    }
+
+    // Returns the first position p >= i such that m_vec[p] is the target trit, or get_num_trits()
+    // if not found, for i <= get_num_trits().
+    uint64_t next(uint64_t i) const {
+        assert(m_vec != nullptr);
+        const uint64_t num_trits = m_vec->get_num_trits();
+        assert(i <= num_trits);
+        if (i == num_trits) {
+            return num_trits;
+        }
+        if (m_layout == rs_layout::sparse) {
+            const uint64_t n = m_positions.rank(i);
+            return n < m_num_target_trits ? m_positions.select(n) : num_trits;
+        }
+
+        // (1) Scan on the nearby trytes
+        const uint64_t tryte_pos = i / TRITS_PER_BYTE;
+        const uint64_t tryte_end = std::min<uint64_t>(tryte_pos + NEAR_SCAN_TRYTES, m_vec->m_trytes.size());
+        const uint64_t k = i % TRITS_PER_BYTE;
+        uint64_t skipped = k == 0 ? 0 : LUT[k - 1][m_vec->m_trytes[tryte_pos]];  // occurrences before i
+        for (uint64_t j = tryte_pos; j < tryte_end; ++j) {
+            const uint8_t tryte = m_vec->m_trytes[j];
+            if (skipped < LUT[4][tryte]) {
+                // The unused trits in the last tryte are filled with 0s
+                const uint64_t p = j * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][skipped][tryte];
+                return std::min(p, num_trits);
+            }
+            skipped = 0;
+        }
+        if (tryte_end == m_vec->m_trytes.size()) {
+            return num_trits;
+        }
+
+        // (2) Search on the directories
+        const uint64_t n = rank(tryte_end * TRITS_PER_BYTE);
+        return n < m_num_target_trits ? select(n) : num_trits;
+    }
+
+    // Returns the last position p < i such that m_vec[p] is the target trit, or get_num_trits()
+    // if not found, for i <= get_num_trits().
+    uint64_t prev(uint64_t i) const {
+        assert(m_vec != nullptr);
+        const uint64_t num_trits = m_vec->get_num_trits();
+        assert(i <= num_trits);
+        if (m_layout == rs_layout::sparse) {
+            const uint64_t n = m_positions.rank(i);
+            return n != 0 ? m_positions.select(n - 1) : num_trits;
+        }
+
+        // (1) Scan on the nearby trytes
+        const uint64_t tryte_pos = i / TRITS_PER_BYTE;
+        const uint64_t tryte_beg = tryte_pos < NEAR_SCAN_TRYTES ? 0 : tryte_pos - NEAR_SCAN_TRYTES;
+        const uint64_t k = i % TRITS_PER_BYTE;
+        if (k != 0) {
+            const uint8_t tryte = m_vec->m_trytes[tryte_pos];
+            const uint64_t cnt = LUT[k - 1][tryte];  // occurrences before i in the tryte
+            if (cnt != 0) {
+                return tryte_pos * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][cnt - 1][tryte];
+            }
+        }
+        for (uint64_t j = tryte_pos; j > tryte_beg; --j) {
+            const uint8_t tryte = m_vec->m_trytes[j - 1];
+            const uint64_t cnt = LUT[4][tryte];
+            if (cnt != 0) {
+                return (j - 1) * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][cnt - 1][tryte];
+            }
+        }
+        if (tryte_beg == 0) {
+            return num_trits;
+        }
+
+        // (2) Search on the directories
+        const uint64_t n = rank(tryte_beg * TRITS_PER_BYTE);
+        return n != 0 ? select(n - 1) : num_trits;
+    }
+
+    uint64_t get_num_trits() const {
+        return m_vec->get_num_trits();
+    }
+    uint64_t get_num_target_trits() const {
+        return m_num_target_trits;
+    }
+    uint64_t get_select_sample_rate() const {
+        return m_select_sample_rate;
+    }
+    uint64_t size_in_bytes() const {
+        return m_large_blocks.size() * sizeof(uint64_t) +  //
+               m_small_blocks.size() * sizeof(Counter) +  //
+               sizeof(m_num_target_trits) +  //
+               m_select_samples.size() * sizeof(uint64_t) + sizeof(m_select_sample_rate) +  //
+               sizeof(m_layout) + m_positions.size_in_bytes();
+    }
+
+    void save(std::ostream& os) const {
+        m_large_blocks.save(os);
+        m_small_blocks.save(os);
+        os.write(reinterpret_cast<const char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+        os.write(reinterpret_cast<const char*>(&m_select_sample_rate), sizeof(m_select_sample_rate));
+        m_select_samples.save(os);
+        os.write(reinterpret_cast<const char*>(&m_layout), sizeof(m_layout));
+        m_positions.save(os);
+    }
+    void load(std::istream& is) {
+        m_large_blocks.load(is);
+        m_small_blocks.load(is);
+        is.read(reinterpret_cast<char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+        is.read(reinterpret_cast<char*>(&m_select_sample_rate), sizeof(m_select_sample_rate));
+        m_select_samples.load(is);
+        is.read(reinterpret_cast<char*>(&m_layout), sizeof(m_layout));
+        m_positions.load(is);
+    }
+    // Views the data saved by save() at ptr (8-byte aligned, e.g., from mmap_file) without copying,
+    // and returns the pointer to the next data. The memory must outlive this object.
+    // Throws std::runtime_error if the data goes past end, unless end is nullptr.
+    const uint8_t* map(const uint8_t* ptr, const uint8_t* end = nullptr) {
+        ptr = m_large_blocks.map(ptr, end);
+        ptr = m_small_blocks.map(ptr, end);
+        ptr = detail::map_value(ptr, end, &m_num_target_trits);
+        ptr = detail::map_value(ptr, end, &m_select_sample_rate);
+        ptr = m_select_samples.map(ptr, end);
+        ptr = detail::map_value(ptr, end, &m_layout);
+        return m_positions.map(ptr, end);
+    }
+
+  private:
+    using directories_type = detail::rank_directories<TRITS_PER_LB, TRITS_PER_SB, Counter>;
+
+    // LUT[k][tryte] is the number of Trit in the first k+1 trits of the tryte.
+    static constexpr const uint8_t (*LUT)[243] = detail::tryte_luts<>::COUNT.table[Trit];
+
+    void build(const trit_vector* vec, directories_type& dirs, uint64_t select_sample_rate) {
+        uint64_t num_target_trits = dirs.num_target_trits[Trit];
+        if (Trit == 0) {
+            // The unused trits in the last tryte are filled with 0s
+            num_target_trits -= vec->m_trytes.size() * TRITS_PER_BYTE - vec->get_num_trits();
+        }
+        build(dirs.large_blocks[Trit], dirs.small_blocks[Trit], num_target_trits, select_sample_rate);
+        m_vec = vec;
+    }
+
+    // Builds the dense layout from the counters computed elsewhere, leaving the vector unset.
+    void build(std::vector<uint64_t>& large_blocks, std::vector<Counter>& small_blocks, uint64_t num_target_trits,
+               uint64_t select_sample_rate) {
+        m_vec = nullptr;
+        m_layout = rs_layout::dense;
+        m_positions = elias_fano();
+        m_large_blocks.steal(large_blocks);
+        m_small_blocks.steal(small_blocks);
+        m_num_target_trits = num_target_trits;
+        build_select_samples(select_sample_rate);
+    }
+
+    void build_sparse(const trit_vector* vec) {
+        m_vec = vec;
+        m_layout = rs_layout::sparse;
+        m_large_blocks.clear();
+        m_small_blocks.clear();
+        m_select_sample_rate = 0;
+        m_select_samples.clear();
+
+        std::vector<uint64_t> positions;
+        for (uint64_t i = 0; i < vec->m_trytes.size(); ++i) {
+            const uint8_t tryte = vec->m_trytes[i];
+            for (uint64_t n = 0; n < LUT[4][tryte]; ++n) {
+                const uint64_t pos = i * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][n][tryte];
+                // The unused trits in the last tryte are filled with 0s
+                if (pos < vec->get_num_trits()) {
+                    positions.push_back(pos);
+                }
+            }
+        }
+        m_positions.build(positions.data(), positions.size(), vec->get_num_trits());
+        m_num_target_trits = positions.size();
+    }
+
+    template <bool UseSimd>
+    uint64_t rank_impl(const uint64_t i) const {
         assert(m_vec != nullptr);
         assert(i < m_vec->get_num_trits());
+        SUCCINCTRITS_STATS_ADD(num_rank, 1);
+
+        if (m_layout == rs_layout::sparse) {
+            return m_positions.rank(i);
+        }
 
         const uint64_t lb_pos = i / TRITS_PER_LB;
         const uint64_t sb_pos = i / TRITS_PER_SB;
@@ -73,6 +524,16 @@ class rs_support {
 
         const uint64_t tryte_pos = i / TRITS_PER_BYTE;
         const uint64_t tryte_beg = tryte_pos / TRYTES_PER_SB * TRYTES_PER_SB;
+
+        SUCCINCTRITS_STATS_ADD(rank_scanned_trytes, tryte_pos - tryte_beg + 1);
+
+        const auto count_trits = detail::get_kernels().count_trits[Trit];
+        if (UseSimd && SIMD_SCAN && count_trits != nullptr) {
+            uint8_t buf[16];
+            const uint8_t* ptr = detail::get_16_trytes(m_vec->m_trytes.data(), m_vec->m_trytes.size(), tryte_beg, buf);
+            return rank + count_trits(ptr, i - tryte_beg * TRITS_PER_BYTE);
+        }
+
         for (uint64_t j = tryte_beg; j < tryte_pos; ++j) {
             rank += LUT[4][m_vec->m_trytes[j]];
         }
@@ -86,16 +547,26 @@ class rs_support {
         return rank;
     }
 
-    // Returns the position of the (n+1)-th occurrence of the target trit in m_vec.
-    uint64_t select(uint64_t n) const {
+    template <bool UseSimd>
+    uint64_t select_impl(uint64_t n) const {
         assert(m_vec != nullptr);
         assert(n < m_num_target_trits);
+        SUCCINCTRITS_STATS_ADD(num_select, 1);
+
+        if (m_layout == rs_layout::sparse) {
+            return m_positions.select(n);
+        }
+
+        // The candidates of the small block including the answer
+        uint64_t sb_left = 0, sb_right = 0;
+        get_sb_candidates(n, sb_left, sb_right);
 
         // (1) Search on Large Blocks
-        uint64_t left = 0;
-        uint64_t right = m_large_blocks.size();
+        uint64_t left = sb_left / LB_PER_SB;
+        uint64_t right = (sb_right - 1) / LB_PER_SB + 1;
 
         while (left + 1 < right) {
+            SUCCINCTRITS_STATS_ADD(select_lb_steps, 1);
             const uint64_t center = (left + right) / 2;
             if (n < m_large_blocks[center]) {
                 right = center;
@@ -108,10 +579,22 @@ class rs_support {
         // (2) Search on Small Blocks
         n = n - m_large_blocks[left];
 
-        left = left * LB_PER_SB;  // position of SB
-        right = std::min<uint64_t>(left + LB_PER_SB, m_small_blocks.size());
+        const uint64_t lb_pos = left;
+        left = std::max<uint64_t>(lb_pos * LB_PER_SB, sb_left);  // position of SB
+        right = std::min<uint64_t>({lb_pos * LB_PER_SB + LB_PER_SB, sb_right, m_small_blocks.size()});
+
+        const auto count_le_u16 = detail::get_kernels().count_le_u16;
+        if (UseSimd && SIMD_SB_SEARCH && count_le_u16 != nullptr && right - left <= SB_LINEAR_SEARCH_LIMIT) {
+            // The small blocks in the same large block are monotone.
+            SUCCINCTRITS_STATS_ADD(select_sb_steps, 1);
+            const uint16_t x = uint16_t(std::min<uint64_t>(n, UINT16_MAX));
+            const uint16_t* values = reinterpret_cast<const uint16_t*>(m_small_blocks.data());
+            left += count_le_u16(values + left + 1, right - left - 1, x);
+            right = left + 1;
+        }
 
         while (left + 1 < right) {
+            SUCCINCTRITS_STATS_ADD(select_sb_steps, 1);
             const uint64_t center = (left + right) / 2;
             if (n < m_small_blocks[center]) {
                 right = center;
@@ -119,227 +602,134 @@ class rs_support {
                 left = center;
             }
         }
-        uint64_t i = left;
-        assert(m_small_blocks[i] <= n);
+        assert(m_small_blocks[left] <= n);
 
         // (3) Search on the remaining trytes
-        n = n - m_small_blocks[i];
-        i = i * TRYTES_PER_SB;  // position of trytes
+        return select_in_sb<UseSimd>(left, n - m_small_blocks[left]);
+    }
+
+    // For each j < size, finds the last position p in [lefts[j], rights[j]) such that values[p] <= xs[j]
+    // and stores it in lefts[j], assuming values are monotone in the range.
+    template <class T>
+    static void interleaved_search(const T* values, uint64_t size, const uint64_t* xs, uint64_t* lefts,
+                                   uint64_t* rights) {
+        for (uint64_t j = 0; j < size; ++j) {
+            __builtin_prefetch(values + (lefts[j] + rights[j]) / 2);
+        }
+        for (bool active = true; active;) {
+            active = false;
+            for (uint64_t j = 0; j < size; ++j) {
+                if (lefts[j] + 1 < rights[j]) {
+                    const uint64_t center = (lefts[j] + rights[j]) / 2;
+                    if (xs[j] < values[center]) {
+                        rights[j] = center;
+                    } else {
+                        lefts[j] = center;
+                    }
+                    __builtin_prefetch(values + (lefts[j] + rights[j]) / 2);
+                    active = true;
+                }
+            }
+        }
+    }
+
+    // Returns the candidates [sb_left, sb_right) of the small block including the (n+1)-th occurrence.
+    void get_sb_candidates(uint64_t n, uint64_t& sb_left, uint64_t& sb_right) const {
+        if (m_select_sample_rate != 0) {
+            const uint64_t x = n / m_select_sample_rate;
+            sb_left = m_select_samples[x];
+            sb_right = m_select_samples[x + 1] + 1;
+        } else {
+            sb_left = 0;
+            sb_right = m_small_blocks.size();
+        }
+    }
+
+    // Returns the position of the (n+1)-th occurrence in the small block of position sb_pos.
+    template <bool UseSimd>
+    uint64_t select_in_sb(uint64_t sb_pos, uint64_t n) const {
+        uint64_t i = sb_pos * TRYTES_PER_SB;  // position of trytes
 
         ++n;
 
-        for (;; ++i) {
-            const uint8_t cnt = LUT[4][m_vec->m_trytes[i]];
-            if (n <= cnt) {
-                break;
+        const auto select_tryte = detail::get_kernels().select_tryte[Trit];
+        if (UseSimd && SIMD_SCAN && select_tryte != nullptr) {
+            uint8_t buf[16];
+            i += select_tryte(detail::get_16_trytes(m_vec->m_trytes.data(), m_vec->m_trytes.size(), i, buf), n);
+        } else {
+            for (;; ++i) {
+                const uint8_t cnt = LUT[4][m_vec->m_trytes[i]];
+                if (n <= cnt) {
+                    break;
+                }
+                n = n - cnt;
             }
-            n = n - cnt;
         }
 
+        SUCCINCTRITS_STATS_ADD(select_scanned_trytes, i - sb_pos * TRYTES_PER_SB + 1);
+
         const uint8_t tryte = m_vec->m_trytes[i];
         assert(n <= LUT[4][tryte]);
-
-        if (n == LUT[0][tryte]) {
-            return i * TRITS_PER_BYTE;
-        } else if (n == LUT[1][tryte]) {
-            return i * TRITS_PER_BYTE + 1;
-        } else if (n == LUT[2][tryte]) {
-            return i * TRITS_PER_BYTE + 2;
-        } else if (n == LUT[3][tryte]) {
-            return i * TRITS_PER_BYTE + 3;
-        } else {
-            assert(n == LUT[4][tryte]);
-            return i * TRITS_PER_BYTE + 4;
-        }
+        return i * TRITS_PER_BYTE + detail::tryte_luts<>::SELECT.table[Trit][n - 1][tryte];
     }
 
-    uint64_t get_num_trits() const {
-        return m_vec->get_num_trits();
-    }
-    uint64_t get_num_target_trits() const {
-        return m_num_target_trits;
-    }
-    uint64_t size_in_bytes() const {
-        return m_large_blocks.size() * sizeof(uint64_t) +  //
-               m_small_blocks.size() * sizeof(uint16_t) +  //
-               sizeof(m_num_target_trits);
-    }
+    void build_select_samples(uint64_t select_sample_rate) {
+        m_select_sample_rate = select_sample_rate;
+        m_select_samples.clear();
+        if (m_select_sample_rate == 0 || m_small_blocks.empty()) {
+            return;
+        }
 
-    void save(std::ostream& os) const {
-        size_t n_L = m_large_blocks.size();
-        os.write(reinterpret_cast<const char*>(&n_L), sizeof(size_t));
-        os.write(reinterpret_cast<const char*>(m_large_blocks.data()), sizeof(uint64_t) * n_L);
-        size_t n_S = m_small_blocks.size();
-        os.write(reinterpret_cast<const char*>(&n_S), sizeof(size_t));
-        os.write(reinterpret_cast<const char*>(m_small_blocks.data()), sizeof(uint16_t) * n_S);
-        os.write(reinterpret_cast<const char*>(&m_num_target_trits), sizeof(m_num_target_trits));
-    }
-    void load(std::istream& is) {
-        size_t n_L = 0;
-        is.read(reinterpret_cast<char*>(&n_L), sizeof(size_t));
-        m_large_blocks.resize(n_L);
-        is.read(reinterpret_cast<char*>(m_large_blocks.data()), sizeof(uint64_t) * n_L);
-        size_t n_S = 0;
-        is.read(reinterpret_cast<char*>(&n_S), sizeof(size_t));
-        m_small_blocks.resize(n_S);
-        is.read(reinterpret_cast<char*>(m_small_blocks.data()), sizeof(uint16_t) * n_S);
-        is.read(reinterpret_cast<char*>(&m_num_target_trits), sizeof(m_num_target_trits));
+        std::vector<uint64_t> select_samples;
+        select_samples.reserve(m_num_target_trits / m_select_sample_rate + 2);
+
+        // The small block including the (n+1)-th occurrence is sampled for every n multiple of the rate.
+        uint64_t n = 0;
+        for (uint64_t i = 0; i < m_small_blocks.size(); ++i) {
+            const uint64_t next_rank = i + 1 < m_small_blocks.size()
+                                           ? m_large_blocks[(i + 1) / LB_PER_SB] + m_small_blocks[i + 1]
+                                           : m_num_target_trits;
+            for (; n < next_rank; n += m_select_sample_rate) {
+                select_samples.push_back(i);
+            }
+        }
+        select_samples.push_back(m_small_blocks.size() - 1);  // sentinel
+        m_select_samples.steal(select_samples);
     }
 
-  private:
-    static const uint8_t LUT[5][243];  // 243 = 3**5
-
     const trit_vector* m_vec = nullptr;
-    std::vector<uint64_t> m_large_blocks;
-    std::vector<uint16_t> m_small_blocks;
+    mappable_vector<uint64_t> m_large_blocks;
+    mappable_vector<Counter> m_small_blocks;
     uint64_t m_num_target_trits = 0;
+    uint64_t m_select_sample_rate = 0;
+    mappable_vector<uint64_t> m_select_samples;  // positions of small blocks
+    rs_layout m_layout = rs_layout::dense;
+    elias_fano m_positions;  // positions of the target trit in the sparse layout
+
+    friend void build_rs_supports(const trit_vector*, rs_support<0>*, rs_support<1>*, rs_support<2>*, uint64_t,
+                                  uint64_t);
+    friend class streaming_builder;
 };
 
-template <>
-const uint8_t rs_support<0>::LUT[5][243] = {
-    {
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-    },
-    {
-        2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0,
-        0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1,
-        0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0,
-        1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0,
-        0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1,
-        0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1,
-        1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0,
-    },
-    {
-        3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1,
-        1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1,
-        0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0,
-        1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1,
-        1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1,
-        0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1,
-        1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0,
-    },
-    {
-        4, 3, 3, 3, 2, 2, 3, 2, 2, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1,
-        1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1,
-        0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 4, 3, 3, 3, 2, 2, 3, 2, 2, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1,
-        2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1,
-        1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 4, 3, 3, 3, 2, 2, 3, 2, 2, 3, 2, 2, 2,
-        1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1,
-        1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0,
-    },
-    {
-        5, 4, 4, 4, 3, 3, 4, 3, 3, 4, 3, 3, 3, 2, 2, 3, 2, 2, 4, 3, 3, 3, 2, 2, 3, 2, 2, 4, 3, 3, 3, 2, 2, 3, 2,
-        2, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 4, 3, 3, 3, 2, 2, 3, 2, 2, 3, 2, 2, 2, 1, 1, 2,
-        1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 4, 3, 3, 3, 2, 2, 3, 2, 2, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1,
-        2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1,
-        1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0, 4, 3, 3, 3, 2, 2, 3, 2, 2, 3, 2, 2, 2,
-        1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1,
-        1, 0, 0, 1, 0, 0, 3, 2, 2, 2, 1, 1, 2, 1, 1, 2, 1, 1, 1, 0, 0, 1, 0, 0, 2, 1, 1, 1, 0, 0, 1, 0, 0,
-    },
-};
-
-template <>
-const uint8_t rs_support<1>::LUT[5][243] = {
-    {
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-    },
-    {
-        0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1,
-        0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0,
-        1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1,
-        0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2,
-        1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1,
-        2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0,
-        1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0,
-    },
-    {
-        0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1,
-        0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1,
-        2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1,
-        0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2,
-        1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2,
-        3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0,
-        1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0,
-    },
-    {
-        0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2,
-        1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1,
-        2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1,
-        0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2,
-        1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2,
-        3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1,
-        2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0,
-    },
-    {
-        0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2,
-        1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1,
-        2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1, 2, 3, 2,
-        1, 2, 1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 3, 4, 3, 4, 5, 4, 3, 4, 3, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1, 2, 3,
-        2, 1, 2, 1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2,
-        3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 2, 3, 2, 3, 4, 3, 2, 3, 2, 1, 2, 1,
-        2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0, 1, 2, 1, 2, 3, 2, 1, 2, 1, 0, 1, 0, 1, 2, 1, 0, 1, 0,
-    },
-};
-
-template <>
-const uint8_t rs_support<2>::LUT[5][243] = {
-    {
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0,
-        1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0,
-        0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-        0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1,
-    },
-    {
-        0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1,
-        2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1,
-        1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1,
-        1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0,
-        1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0,
-        0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1,
-        0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2,
-    },
-    {
-        0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1,
-        2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1,
-        1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2,
-        2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0,
-        1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0,
-        0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2,
-        1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3,
-    },
-    {
-        0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1,
-        2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2,
-        2, 3, 2, 2, 3, 2, 2, 3, 3, 3, 4, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2,
-        2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1,
-        2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 2, 2, 3, 2, 2, 3, 3, 3, 4, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0,
-        0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2,
-        1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 2, 2, 3, 2, 2, 3, 3, 3, 4,
-    },
-    {
-        0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1,
-        2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2,
-        2, 3, 2, 2, 3, 2, 2, 3, 3, 3, 4, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2,
-        2, 2, 3, 0, 0, 1, 0, 0, 1, 1, 1, 2, 0, 0, 1, 0, 0, 1, 1, 1, 2, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1,
-        2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 2, 2, 3, 2, 2, 3, 3, 3, 4, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1,
-        1, 2, 2, 2, 3, 2, 2, 3, 2, 2, 3, 3, 3, 4, 1, 1, 2, 1, 1, 2, 2, 2, 3, 1, 1, 2, 1, 1, 2, 2, 2, 3, 2, 2, 3,
-        2, 2, 3, 3, 3, 4, 2, 2, 3, 2, 2, 3, 3, 3, 4, 2, 2, 3, 2, 2, 3, 3, 3, 4, 3, 3, 4, 3, 3, 4, 4, 4, 5,
-    },
-};
+template <uint8_t Trit, uint64_t TritsPerLB, uint64_t TritsPerSB, class Counter>
+constexpr const uint8_t (*rs_support<Trit, TritsPerLB, TritsPerSB, Counter>::LUT)[243];
+
+// Builds the indexes of the three trits in a single pass over the trytes with num_threads threads.
+// Any of rs_0, rs_1 and rs_2 can be nullptr to skip it.
+inline void build_rs_supports(const trit_vector* vec, rs_support<0>* rs_0, rs_support<1>* rs_1, rs_support<2>* rs_2,
+                              uint64_t num_threads, uint64_t select_sample_rate = 0) {
+    const uint32_t targets = (rs_0 != nullptr ? 1U : 0U) | (rs_1 != nullptr ? 2U : 0U) | (rs_2 != nullptr ? 4U : 0U);
+    detail::rank_directories<rs_support<0>::TRITS_PER_LB, rs_support<0>::TRITS_PER_SB> dirs(
+        vec->m_trytes.data(), vec->m_trytes.size(), targets, num_threads);
+    if (rs_0 != nullptr) {
+        rs_0->build(vec, dirs, select_sample_rate);
+    }
+    if (rs_1 != nullptr) {
+        rs_1->build(vec, dirs, select_sample_rate);
+    }
+    if (rs_2 != nullptr) {
+        rs_2->build(vec, dirs, select_sample_rate);
+    }
+}
 
 }  // namespace succinctrits
\ No newline at end of file
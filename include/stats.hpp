@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+// Opt-in instrumentation of the hot paths in trit_vector and rs_support.
+//
+// Define SUCCINCTRITS_ENABLE_STATS before including any header (or configure CMake with
+// -DSUCCINCTRITS_ENABLE_STATS=ON) to count the work of every query in stats::get(). Otherwise
+// SUCCINCTRITS_STATS_ADD expands to nothing and the queries are compiled exactly as before.
+#ifdef SUCCINCTRITS_ENABLE_STATS
+#define SUCCINCTRITS_STATS_ADD(counter, n) (::succinctrits::stats::get().counter += (n))
+#else
+#define SUCCINCTRITS_STATS_ADD(counter, n) ((void)0)
+#endif
+
+namespace succinctrits {
+
+// Counters of the queries. They are thread-local, so that the queries need no synchronization;
+// each thread reads and resets its own counters.
+struct stats {
+    uint64_t num_access = 0;
+    uint64_t num_rank = 0;
+    uint64_t num_select = 0;
+    uint64_t rank_scanned_trytes = 0;  // trytes read after the small block
+    uint64_t select_lb_steps = 0;  // steps of the binary search on large blocks
+    uint64_t select_sb_steps = 0;  // steps of the search on small blocks
+    uint64_t select_scanned_trytes = 0;  // trytes read in the small block
+
+    static stats& get() {
+        static thread_local stats s;
+        return s;
+    }
+
+    static constexpr bool enabled() {
+#ifdef SUCCINCTRITS_ENABLE_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void reset() {
+        *this = stats();
+    }
+
+    void print(std::ostream& os) const {
+        os << "# stats: " << num_access << " access, " << num_rank << " rank, " << num_select << " select"
+           << std::endl;
+        if (num_rank != 0) {
+            os << "#   rank:   " << double(rank_scanned_trytes) / num_rank << " trytes/op" << std::endl;
+        }
+        if (num_select != 0) {
+            os << "#   select: " << double(select_lb_steps) / num_select << " LB steps/op, "
+               << double(select_sb_steps) / num_select << " SB steps/op, "
+               << double(select_scanned_trytes) / num_select << " trytes/op" << std::endl;
+        }
+    }
+};
+
+}  // namespace succinctrits
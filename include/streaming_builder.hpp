@@ -0,0 +1,285 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "container.hpp"
+#include "rs_support.hpp"
+#include "trit_vector.hpp"
+#include "tryte_lut.hpp"
+
+namespace succinctrits {
+
+// Builder writing a container file of a trit_vector and its rs_support indexes while the trits are
+// appended, for vectors larger than the memory.
+//
+// The trits are packed and written chunk by chunk, and only the directories of the indexes (about
+// 0.32 bits per trit each) are kept in memory until finish(). The file is identical to the one
+// written by container_writer with the trit_vector and rs_support<t> for each target t built in
+// memory, so it can be loaded or mapped by container_reader in the same way.
+//
+//   succinctrits::streaming_builder b("trits.sct", 0b011);  // indexes on 0s and 1s
+//   std::ifstream ifs("trits.bin", std::ios::binary);  // a trit (0, 1 or 2) per byte
+//   b.append(ifs);
+//   b.finish();
+class streaming_builder {
+  public:
+    static constexpr uint64_t TRITS_PER_BYTE = trit_vector::TRITS_PER_BYTE;
+    static constexpr uint64_t DEFAULT_CHUNK_TRITS = uint64_t(1) << 24;
+
+    // Writes the container to path with the indexes on the trits in the bit mask targets, e.g.,
+    // 0b101 for 0s and 2s. The trits are buffered in chunks of chunk_trits.
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit streaming_builder(const char* path, uint32_t targets = 0b111, uint64_t select_sample_rate = 0,
+                               uint64_t chunk_trits = DEFAULT_CHUNK_TRITS)
+        : m_path(path),
+          m_targets(targets),
+          m_select_sample_rate(select_sample_rate),
+          m_trits(std::max<uint64_t>(chunk_trits / TRITS_PER_BYTE, 1) * TRITS_PER_BYTE),
+          m_trytes(m_trits.size() / TRITS_PER_BYTE) {
+        assert(targets < 8);
+
+        m_fs.open(path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!m_fs) {
+            throw std::runtime_error(std::string("failed to open ") + path);
+        }
+
+        // The header and table are written again in finish().
+        m_entries.resize(1);
+        m_entries[0].type = uint32_t(container_section<trit_vector>::type);
+        m_entries[0].params = container_section<trit_vector>::params;
+        add_entry<0>();
+        add_entry<1>();
+        add_entry<2>();
+        write_header();
+
+        // The number of trytes in the payload of trit_vector is written in finish().
+        m_entries[0].offset = align(get_pos());
+        write_zeros(m_entries[0].offset - get_pos());
+        const size_t num_trytes = 0;
+        m_fs.write(reinterpret_cast<const char*>(&num_trytes), sizeof(num_trytes));
+    }
+
+    streaming_builder(const streaming_builder&) = delete;
+    streaming_builder& operator=(const streaming_builder&) = delete;
+
+    // Appends trits[0..num_trits), each of which must be less than 3.
+    void append(const uint8_t* trits, uint64_t num_trits) {
+        assert(!m_finished);
+        while (num_trits != 0) {
+            const uint64_t num = std::min(num_trits, m_trits.size() - m_buf_size);
+            std::memcpy(m_trits.data() + m_buf_size, trits, num);
+            m_buf_size += num;
+            trits += num;
+            num_trits -= num;
+            if (m_buf_size == m_trits.size()) {
+                flush<false>();
+            }
+        }
+    }
+
+    // Appends the trits read from is until its end, a trit (0, 1 or 2) per byte.
+    // Throws std::runtime_error if it includes any other byte or fails to be read.
+    void append(std::istream& is) {
+        assert(!m_finished);
+        while (is) {
+            char* buf = reinterpret_cast<char*>(m_trits.data() + m_buf_size);
+            is.read(buf, std::streamsize(m_trits.size() - m_buf_size));
+            m_buf_size += uint64_t(is.gcount());
+            if (m_buf_size == m_trits.size()) {
+                flush<true>();
+            }
+        }
+        if (is.bad()) {
+            throw std::runtime_error("failed to read the trits");
+        }
+        flush<true>();
+    }
+
+    // Writes the rest of the trits and the indexes, and completes the file.
+    // Throws std::runtime_error if the file fails to be written.
+    void finish() {
+        assert(!m_finished);
+        m_num_trits = get_num_trits();
+        m_finished = true;
+
+        // The unused trits in the last tryte are filled with 0s. The rest of append(is) is checked here.
+        const uint64_t buf_end = (m_buf_size + TRITS_PER_BYTE - 1) / TRITS_PER_BYTE * TRITS_PER_BYTE;
+        std::fill(m_trits.data() + m_buf_size, m_trits.data() + buf_end, uint8_t(0));
+        m_buf_size = buf_end;
+        flush<true>();
+
+        // The rest of the payload of trit_vector as mappable_vector<uint8_t>::save() and trit_vector::save()
+        write_zeros((mappable_vector<uint8_t>::ALIGNMENT - m_num_trytes % mappable_vector<uint8_t>::ALIGNMENT) %
+                    mappable_vector<uint8_t>::ALIGNMENT);
+        m_fs.write(reinterpret_cast<const char*>(&m_num_trits), sizeof(m_num_trits));
+        const uint64_t end = get_pos();
+        m_entries[0].size = end - m_entries[0].offset;
+
+        m_fs.seekp(std::streamoff(m_entries[0].offset));
+        const size_t num_trytes = m_num_trytes;
+        m_fs.write(reinterpret_cast<const char*>(&num_trytes), sizeof(num_trytes));
+        m_entries[0].checksum = compute_checksum(m_entries[0].offset, m_entries[0].size);
+        m_fs.seekp(std::streamoff(end));
+
+        write_index<0>();
+        write_index<1>();
+        write_index<2>();
+
+        m_fs.seekp(0);
+        write_header();
+        m_fs.close();
+        if (!m_fs) {
+            throw std::runtime_error("failed to write " + m_path);
+        }
+    }
+
+    uint64_t get_num_trits() const {
+        return m_finished ? m_num_trits : m_num_trytes * TRITS_PER_BYTE + m_buf_size;
+    }
+    // Returns the bytes of memory in use, i.e., the chunk buffers and the directories.
+    uint64_t size_in_bytes() const {
+        uint64_t bytes = m_trits.size() + m_trytes.size();
+        for (uint32_t t = 0; t < 3; ++t) {
+            bytes += m_large_blocks[t].capacity() * sizeof(uint64_t) + m_small_blocks[t].capacity() * sizeof(uint16_t);
+        }
+        return bytes;
+    }
+
+  private:
+    static constexpr uint64_t TRYTES_PER_LB = rs_support<0>::TRITS_PER_LB / TRITS_PER_BYTE;
+    static constexpr uint64_t TRYTES_PER_SB = rs_support<0>::TRITS_PER_SB / TRITS_PER_BYTE;
+
+    std::string m_path;
+    std::fstream m_fs;
+    std::vector<container_section_entry> m_entries;
+    uint32_t m_targets = 0;
+    uint64_t m_select_sample_rate = 0;
+    bool m_finished = false;
+
+    std::vector<uint8_t> m_trits;  // chunk of the trits to be packed
+    std::vector<uint8_t> m_trytes;  // chunk of the packed trytes
+    uint64_t m_buf_size = 0;  // number of the trits in m_trits
+    uint64_t m_num_trytes = 0;  // number of the trytes written
+    uint64_t m_num_trits = 0;  // set in finish()
+
+    // Directories of rs_support<t> for each target t
+    std::vector<uint64_t> m_large_blocks[3];
+    std::vector<uint16_t> m_small_blocks[3];
+    uint64_t m_ranks[3] = {0, 0, 0};
+
+    template <uint8_t Trit>
+    void add_entry() {
+        if (m_targets >> Trit & 1) {
+            container_section_entry entry{};
+            entry.type = uint32_t(container_section<rs_support<Trit>>::type);
+            entry.params = container_section<rs_support<Trit>>::params;
+            m_entries.push_back(entry);
+        }
+    }
+
+    // Packs and writes the complete trytes in m_trits, and moves the rest to the front.
+    template <bool Check>
+    void flush() {
+        const uint64_t num_trytes = m_buf_size / TRITS_PER_BYTE;
+        if (!detail::pack_trytes<Check>(m_trits.data(), num_trytes, m_trytes.data())) {
+            throw std::runtime_error("invalid trits of 3 or more in the input");
+        }
+        for (uint64_t j = 0; j < num_trytes; ++j) {
+            const uint64_t i = m_num_trytes + j;
+            for (uint32_t t = 0; t < 3; ++t) {
+                if (m_targets >> t & 1) {
+                    if (i % TRYTES_PER_LB == 0) {
+                        m_large_blocks[t].push_back(m_ranks[t]);
+                    }
+                    if (i % TRYTES_PER_SB == 0) {
+                        m_small_blocks[t].push_back(uint16_t(m_ranks[t] - m_large_blocks[t].back()));
+                    }
+                    m_ranks[t] += detail::tryte_luts<>::COUNT.table[t][4][m_trytes[j]];
+                }
+            }
+        }
+        m_fs.write(reinterpret_cast<const char*>(m_trytes.data()), std::streamsize(num_trytes));
+        if (!m_fs) {
+            throw std::runtime_error("failed to write " + m_path);
+        }
+
+        m_num_trytes += num_trytes;
+        const uint64_t num_rest = m_buf_size - num_trytes * TRITS_PER_BYTE;
+        std::memmove(m_trits.data(), m_trits.data() + num_trytes * TRITS_PER_BYTE, num_rest);
+        m_buf_size = num_rest;
+    }
+
+    template <uint8_t Trit>
+    void write_index() {
+        if ((m_targets >> Trit & 1) == 0) {
+            return;
+        }
+        uint64_t num_target_trits = m_ranks[Trit];
+        if (Trit == 0) {
+            // The unused trits in the last tryte are filled with 0s
+            num_target_trits -= m_num_trytes * TRITS_PER_BYTE - m_num_trits;
+        }
+        rs_support<Trit> rs;
+        rs.build(m_large_blocks[Trit], m_small_blocks[Trit], num_target_trits, m_select_sample_rate);
+
+        container_section_entry& entry = *std::find_if(m_entries.begin(), m_entries.end(), [](const auto& e) {
+            return e.type == uint32_t(container_section<rs_support<Trit>>::type);
+        });
+        entry.offset = align(get_pos());
+        write_zeros(entry.offset - get_pos());
+
+        detail::checksum_streambuf buf(m_fs.rdbuf());
+        std::ostream os(&buf);
+        rs.save(os);
+        entry.size = buf.get_size();
+        entry.checksum = buf.get_checksum();
+    }
+
+    void write_header() {
+        container_header header{};
+        std::memcpy(header.magic, detail::container_magic(), sizeof(header.magic));
+        header.version = container_header::VERSION;
+        header.endian_marker = container_header::ENDIAN_MARKER;
+        header.num_sections = m_entries.size();
+        m_fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_fs.write(reinterpret_cast<const char*>(m_entries.data()),
+                   std::streamsize(sizeof(container_section_entry) * m_entries.size()));
+    }
+
+    // Reads back the section in chunks, since its first bytes were written last.
+    uint64_t compute_checksum(uint64_t offset, uint64_t size) {
+        detail::checksum64 checksum;
+        m_fs.seekg(std::streamoff(offset));
+        while (size != 0) {
+            const uint64_t num = std::min<uint64_t>(size, m_trits.size());
+            m_fs.read(reinterpret_cast<char*>(m_trits.data()), std::streamsize(num));
+            checksum.update(m_trits.data(), num);
+            size -= num;
+        }
+        if (!m_fs) {
+            throw std::runtime_error("failed to read back " + m_path);
+        }
+        return checksum.finish();
+    }
+
+    uint64_t get_pos() {
+        return uint64_t(m_fs.tellp());
+    }
+    static uint64_t align(uint64_t pos) {
+        return (pos + container_writer::ALIGNMENT - 1) / container_writer::ALIGNMENT * container_writer::ALIGNMENT;
+    }
+    void write_zeros(uint64_t size) {
+        static const char zeros[container_writer::ALIGNMENT] = {};
+        assert(size <= container_writer::ALIGNMENT);
+        m_fs.write(zeros, std::streamsize(size));
+    }
+};
+
+}  // namespace succinctrits
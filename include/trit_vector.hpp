@@ -1,20 +1,87 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <type_traits>
 #include <vector>
 
+#include "mappable_vector.hpp"
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "tryte_lut.hpp"
+#include "tryte_simd.hpp"
+
 namespace succinctrits {
 
-template <uint8_t>
+template <uint8_t Trit, uint64_t TritsPerLB = 65550, uint64_t TritsPerSB = 50, class Counter = uint16_t>
 class rs_support;
+class fused_rs_support;
+class dynamic_trit_vector;
+class trit_vector;
+
+namespace detail {
+
+// Packs trits[0..num_trytes*5) into trytes[0..num_trytes). If Check is true, returns false if any trit
+// is 3 or more.
+// The five trits in the lower bytes of a 64-bit word x are packed by a single multiplication,
+// whose fifth byte is t0 + 3*t1 + 9*t2 + 27*t3 + 81*t4 without any carry from the lower bytes.
+// The upper three bytes of x only affect the sixth and higher bytes.
+template <bool Check>
+inline bool pack_trytes(const uint8_t* trits, uint64_t num_trytes, uint8_t* trytes) {
+    const auto kernel = get_kernels().pack_trytes;
+    if (kernel != nullptr) {
+        const bool valid = kernel(trits, num_trytes, trytes);
+        assert(Check || valid);
+        return !Check || valid;
+    }
+
+    static constexpr uint64_t MULTIPLIER = 81ULL | 27ULL << 8 | 9ULL << 16 | 3ULL << 24 | 1ULL << 32;
+    // A byte has the top bit in (b | (b + 0x7D)) iff it is 3 or more.
+    static constexpr uint64_t CHECK_ADDEND = 0x7D7D7D7D7DULL;
+    static constexpr uint64_t CHECK_MASK = 0x8080808080ULL;
+
+    uint64_t invalid = 0;
+    auto pack = [&](uint64_t x) {
+        assert(Check || ((x | (x + CHECK_ADDEND)) & CHECK_MASK) == 0);
+        if (Check) {
+            invalid |= (x | (x + CHECK_ADDEND)) & CHECK_MASK;
+        }
+        return uint8_t((x * MULTIPLIER) >> 32);
+    };
+
+    uint64_t j = 0;
+    for (; j + 1 < num_trytes; ++j) {  // eight bytes can be read
+        uint64_t x = 0;
+        std::memcpy(&x, trits + j * 5, sizeof(uint64_t));
+        trytes[j] = pack(x);
+    }
+    for (; j < num_trytes; ++j) {
+        uint64_t x = 0;
+        std::memcpy(&x, trits + j * 5, 5);
+        trytes[j] = pack(x);
+    }
+    return invalid == 0;
+}
+
+}  // namespace detail
+
+inline void build_rs_supports(const trit_vector* vec, rs_support<0>* rs_0, rs_support<1>* rs_1, rs_support<2>* rs_2,
+                              uint64_t num_threads, uint64_t select_sample_rate);
 
 class trit_vector {
   public:
+    static constexpr uint64_t TRITS_PER_BYTE = 5;
+
     class builder {
       public:
         builder() = default;
 
+        // The trit_vector built from this builder places its trytes in memory from resource.
+        explicit builder(memory_resource* resource) : m_resource(resource) {}
+
         void reserve(uint64_t capa) {
             m_trytes.reserve(capa / TRITS_PER_BYTE + 1);
         }
@@ -38,10 +105,123 @@ class trit_vector {
             }
         }
 
+        // Appends trits[0..num_trits), packing five trits at once.
+        void append(const uint8_t* trits, uint64_t num_trits) {
+            append_impl<false>(trits, num_trits);
+        }
+        // Same as append() but checks that every trit is less than 3 in the same pass.
+        // If not, nothing is appended and false is returned.
+        bool try_append(const uint8_t* trits, uint64_t num_trits) {
+            const uint64_t size = m_trytes.size();
+            const uint8_t back = size != 0 ? m_trytes.back() : 0;
+            const uint64_t num = m_num_trits;
+            const uint8_t count = m_count;
+
+            if (append_impl<true>(trits, num_trits)) {
+                return true;
+            }
+            m_trytes.resize(size);
+            if (size != 0) {
+                m_trytes.back() = back;
+            }
+            m_num_trits = num;
+            m_count = count;
+            return false;
+        }
+
       private:
         std::vector<uint8_t> m_trytes;
         uint64_t m_num_trits = 0;
         uint8_t m_count = 0;
+        memory_resource* m_resource = nullptr;
+
+        template <bool Check>
+        bool append_impl(const uint8_t* trits, uint64_t num_trits) {
+            uint64_t i = 0;
+
+            // Fill the last tryte
+            for (; i < num_trits && m_count != 0; ++i) {
+                if (Check && 3 <= trits[i]) {
+                    return false;
+                }
+                push_back(trits[i]);
+            }
+
+            const uint64_t num_trytes = (num_trits - i) / TRITS_PER_BYTE;
+            const uint64_t beg = m_trytes.size();
+            m_trytes.resize(beg + num_trytes);
+            if (!detail::pack_trytes<Check>(trits + i, num_trytes, m_trytes.data() + beg)) {
+                return false;
+            }
+            i += num_trytes * TRITS_PER_BYTE;
+            m_num_trits += num_trytes * TRITS_PER_BYTE;
+
+            for (; i < num_trits; ++i) {
+                if (Check && 3 <= trits[i]) {
+                    return false;
+                }
+                push_back(trits[i]);
+            }
+            return true;
+        }
+
+        friend class trit_vector;
+    };
+
+    // Forward iterator decoding a whole tryte at once
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint8_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint8_t*;
+        using reference = uint8_t;
+
+        const_iterator() = default;
+
+        uint8_t operator*() const {
+            assert(m_pos < m_vec->m_num_trits);
+            return uint8_t(m_trits & 0xFF);
+        }
+        const_iterator& operator++() {
+            ++m_pos;
+            if (m_pos % TRITS_PER_BYTE == 0) {
+                decode();
+            } else {
+                m_trits >>= 8;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const const_iterator& other) const {
+            return m_pos == other.m_pos;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return m_pos != other.m_pos;
+        }
+
+        uint64_t get_position() const {
+            return m_pos;
+        }
+
+      private:
+        const trit_vector* m_vec = nullptr;
+        uint64_t m_pos = 0;
+        uint64_t m_trits = 0;  // the remaining trits of the current tryte in bytes
+
+        const_iterator(const trit_vector* vec, uint64_t pos) : m_vec(vec), m_pos(pos) {
+            decode();
+            m_trits >>= pos % TRITS_PER_BYTE * 8;
+        }
+        void decode() {
+            if (m_pos < m_vec->m_num_trits) {
+                m_trits = detail::tryte_luts<>::EXPAND.table[m_vec->m_trytes[m_pos / TRITS_PER_BYTE]];
+            }
+        }
 
         friend class trit_vector;
     };
@@ -53,27 +233,65 @@ class trit_vector {
     trit_vector(Iterator it, uint64_t num_trits) {
         build(it, num_trits);
     }
+    template <class RandomIterator>
+    trit_vector(RandomIterator it, uint64_t num_trits, uint64_t num_threads) {
+        build(it, num_trits, num_threads);
+    }
     explicit trit_vector(builder* b) {
         build(b);
     }
 
     template <class Iterator>
     void build(Iterator it, uint64_t num_trits) {
+        // Contiguous arrays of bytes are packed in bulk.
+        build_impl(it, num_trits, std::is_convertible<Iterator, const uint8_t*>());
+    }
+    // Packs the trits in the contiguous array trits[0..num_trits).
+    void build_from_span(const uint8_t* trits, uint64_t num_trits) {
         builder b;
-        b.reserve(num_trits);
-        for (uint64_t i = 0; i < num_trits; ++i) {
-            b.push_back(*it);
-            ++it;
-        }
+        b.append(trits, num_trits);
         build(&b);
     }
+
+    // Packs the trits with num_threads threads. The result is identical to build(it, num_trits).
+    template <class RandomIterator>
+    void build(RandomIterator it, uint64_t num_trits, uint64_t num_threads) {
+        std::vector<uint8_t> trytes((num_trits + TRITS_PER_BYTE - 1) / TRITS_PER_BYTE);
+
+        detail::parallel_for(trytes.size(), num_threads, [&](uint64_t beg, uint64_t end) {
+            for (uint64_t j = beg; j < end; ++j) {
+                const uint64_t pos = j * TRITS_PER_BYTE;
+                const uint64_t len = std::min<uint64_t>(num_trits - pos, uint64_t(TRITS_PER_BYTE));
+                uint8_t tryte = 0;
+                for (uint64_t k = len; k != 0; --k) {
+                    assert(it[pos + k - 1] < 3);
+                    tryte = uint8_t(tryte * 3 + it[pos + k - 1]);
+                }
+                trytes[j] = tryte;
+            }
+        });
+
+        m_trytes.steal(trytes);
+        m_num_trits = num_trits;
+    }
     void build(builder* b) {
-        m_trytes = std::move(b->m_trytes);
+        m_trytes.steal(b->m_trytes);
         m_num_trits = b->m_num_trits;
+        if (b->m_resource != nullptr) {
+            m_trytes.relocate(b->m_resource);
+        }
+        *b = builder();
+    }
+
+    // Moves the trytes into memory from resource (e.g., huge_page_resource or numa_resource), which
+    // must outlive this object. The rs_supports on this vector remain valid.
+    void relocate(memory_resource* resource) {
+        m_trytes.relocate(resource);
     }
 
     uint8_t get(uint64_t i) const {
         assert(i < m_num_trits);
+        SUCCINCTRITS_STATS_ADD(num_access, 1);
 
         const uint64_t pos = i / TRITS_PER_BYTE;
         const uint64_t mod = i % TRITS_PER_BYTE;
@@ -100,6 +318,118 @@ class trit_vector {
         return get(i);
     }
 
+    // Decodes the trits between positions beg and end-1 into out[0..end-beg).
+    void extract(uint64_t beg, uint64_t end, uint8_t* out) const {
+        assert(beg <= end && end <= m_num_trits);
+
+        uint64_t i = beg;
+        for (; i < end && i % TRITS_PER_BYTE != 0; ++i) {
+            *out++ = get(i);
+        }
+
+        const auto kernel = detail::get_kernels().unpack_trytes;
+        if (kernel != nullptr) {
+            const uint64_t num_trytes = (end - i) / TRITS_PER_BYTE;
+            kernel(m_trytes.data() + i / TRITS_PER_BYTE, num_trytes, out);
+            i += num_trytes * TRITS_PER_BYTE;
+            out += num_trytes * TRITS_PER_BYTE;
+        }
+
+        // Each tryte is expanded into eight bytes, of which the last three are overwritten next.
+        const uint64_t* expand = detail::tryte_luts<>::EXPAND.table;
+        for (uint64_t pos = i / TRITS_PER_BYTE; i + sizeof(uint64_t) <= end; i += TRITS_PER_BYTE, ++pos) {
+            std::memcpy(out, &expand[m_trytes[pos]], sizeof(uint64_t));
+            out += TRITS_PER_BYTE;
+        }
+
+        for (; i < end; ++i) {
+            *out++ = get(i);
+        }
+    }
+
+    // Calls fn(i) for each position i in [beg, end) where Trit occurs, in increasing order.
+    // Each tryte is looked up once for the mask of the positions of Trit, so it costs time proportional
+    // to the number of trytes in the range plus the number of occurrences. The positions are collected
+    // into a buffer without branches on the trits, and then passed to fn.
+    template <uint8_t Trit, class Function>
+    void for_each_occurrence(uint64_t beg, uint64_t end, Function fn) const {
+        static_assert(Trit < 3, "");
+        assert(beg <= end && end <= m_num_trits);
+        if (beg == end) {
+            return;
+        }
+
+        const uint8_t* occur = detail::tryte_luts<>::OCCUR.table[Trit];
+        uint64_t buf[OCCURRENCE_BLOCK * TRITS_PER_BYTE];
+        uint64_t num = 0;
+        auto collect = [&](uint64_t pos, uint32_t bits) {
+            for (uint32_t k = 0; k < TRITS_PER_BYTE; ++k) {
+                buf[num] = pos * TRITS_PER_BYTE + k;
+                num += bits >> k & 1;
+            }
+        };
+        auto flush = [&]() {
+            for (uint64_t j = 0; j < num; ++j) {
+                fn(buf[j]);
+            }
+            num = 0;
+        };
+
+        uint64_t pos = beg / TRITS_PER_BYTE;
+        const uint64_t last = (end - 1) / TRITS_PER_BYTE;
+        const uint32_t head = 0x1Fu << (beg % TRITS_PER_BYTE);  // trits at beg or later in the first tryte
+        const uint32_t tail = (2u << ((end - 1) % TRITS_PER_BYTE)) - 1;  // trits before end in the last tryte
+        if (pos == last) {
+            collect(pos, occur[m_trytes[pos]] & head & tail);
+            flush();
+            return;
+        }
+        collect(pos, occur[m_trytes[pos]] & head);
+        for (++pos; pos < last;) {
+            const uint64_t block_end = std::min(last, pos + OCCURRENCE_BLOCK - 1);
+            for (; pos < block_end; ++pos) {
+                collect(pos, occur[m_trytes[pos]]);
+            }
+            flush();
+        }
+        collect(pos, occur[m_trytes[pos]] & tail);
+        flush();
+    }
+
+    // Writes the positions in [beg, end) where Trit occurs to out in increasing order, and returns the
+    // iterator past the last written one.
+    template <uint8_t Trit, class OutputIterator>
+    OutputIterator find_occurrences(uint64_t beg, uint64_t end, OutputIterator out) const {
+        for_each_occurrence<Trit>(beg, end, [&](uint64_t i) {
+            *out = i;
+            ++out;
+        });
+        return out;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const {
+        return const_iterator(this, m_num_trits);
+    }
+    // Returns the iterator at position i (<= get_num_trits())
+    const_iterator iterator_at(uint64_t i) const {
+        assert(i <= m_num_trits);
+        return const_iterator(this, i);
+    }
+
+    // Computes trits[j] = get(positions[j]) for 0 <= j < num.
+    // The trytes of following queries are prefetched to overlap the cache misses.
+    void access_batch(const uint64_t* positions, uint64_t num, uint8_t* trits) const {
+        for (uint64_t j = 0; j < num; ++j) {
+            if (j + PREFETCH_DISTANCE < num) {
+                __builtin_prefetch(m_trytes.data() + positions[j + PREFETCH_DISTANCE] / TRITS_PER_BYTE);
+            }
+            trits[j] = get(positions[j]);
+        }
+    }
+
     uint64_t get_num_trits() const {
         return m_num_trits;
     }
@@ -108,29 +438,50 @@ class trit_vector {
     }
 
     void save(std::ostream& os) const {
-        size_t n = m_trytes.size();
-        os.write(reinterpret_cast<const char*>(&n), sizeof(size_t));
-        os.write(reinterpret_cast<const char*>(m_trytes.data()), sizeof(uint8_t) * n);
+        m_trytes.save(os);
         os.write(reinterpret_cast<const char*>(&m_num_trits), sizeof(uint64_t));
     }
 
     void load(std::istream& is) {
-        size_t n = 0;
-        is.read(reinterpret_cast<char*>(&n), sizeof(size_t));
-        m_trytes.resize(n);
-        is.read(reinterpret_cast<char*>(m_trytes.data()), sizeof(uint8_t) * n);
+        m_trytes.load(is);
         is.read(reinterpret_cast<char*>(&m_num_trits), sizeof(uint64_t));
     }
 
+    // Views the data saved by save() at ptr (8-byte aligned, e.g., from mmap_file) without copying,
+    // and returns the pointer to the next data. The memory must outlive this object.
+    // Throws std::runtime_error if the data goes past end, unless end is nullptr.
+    const uint8_t* map(const uint8_t* ptr, const uint8_t* end = nullptr) {
+        ptr = m_trytes.map(ptr, end);
+        return detail::map_value(ptr, end, &m_num_trits);
+    }
+
   private:
-    static constexpr uint64_t TRITS_PER_BYTE = 5;
+    static constexpr uint64_t PREFETCH_DISTANCE = 16;
+    static constexpr uint64_t OCCURRENCE_BLOCK = 64;  // trytes scanned before calling back
+
+    void build_impl(const uint8_t* trits, uint64_t num_trits, std::true_type) {
+        build_from_span(trits, num_trits);
+    }
+    template <class Iterator>
+    void build_impl(Iterator it, uint64_t num_trits, std::false_type) {
+        builder b;
+        b.reserve(num_trits);
+        for (uint64_t i = 0; i < num_trits; ++i) {
+            b.push_back(*it);
+            ++it;
+        }
+        build(&b);
+    }
 
-    std::vector<uint8_t> m_trytes;  // each of 5 trits
+    mappable_vector<uint8_t> m_trytes;  // each of 5 trits
     uint64_t m_num_trits = 0;
 
-    friend class rs_support<0>;
-    friend class rs_support<1>;
-    friend class rs_support<2>;
+    template <uint8_t, uint64_t, uint64_t, class>
+    friend class rs_support;
+    friend class fused_rs_support;
+    friend class dynamic_trit_vector;
+    friend void build_rs_supports(const trit_vector*, rs_support<0>*, rs_support<1>*, rs_support<2>*, uint64_t,
+                                  uint64_t);
 };
 
 }  // namespace succinctrits
\ No newline at end of file
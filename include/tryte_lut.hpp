@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+
+namespace succinctrits {
+namespace detail {
+
+// Lookup tables on trytes (i.e., five trits packed into a byte) generated at compile time.
+
+// FUSED_LUT[k][tryte] holds the numbers of 0s and 1s in the first k+1 trits of the tryte,
+// where the lower and upper bytes keep the counts of 0s and 1s, respectively.
+struct fused_lut_type {
+    uint16_t table[5][243];
+};
+
+constexpr fused_lut_type make_fused_lut() {
+    fused_lut_type lut{};
+    for (uint32_t tryte = 0; tryte < 243; ++tryte) {
+        uint32_t t = tryte;
+        uint16_t cnt = 0;
+        for (uint32_t k = 0; k < 5; ++k) {
+            const uint32_t digit = t % 3;
+            t /= 3;
+            if (digit == 0) {
+                cnt += 1;
+            } else if (digit == 1) {
+                cnt += 1 << 8;
+            }
+            lut.table[k][tryte] = cnt;
+        }
+    }
+    return lut;
+}
+
+// COUNT_LUT[t][k][tryte] holds the number of trit t in the first k+1 trits of the tryte.
+struct count_lut_type {
+    uint8_t table[3][5][243];
+};
+
+constexpr count_lut_type make_count_lut() {
+    count_lut_type lut{};
+    for (uint32_t tryte = 0; tryte < 243; ++tryte) {
+        uint32_t t = tryte;
+        uint8_t cnts[3] = {0, 0, 0};
+        for (uint32_t k = 0; k < 5; ++k) {
+            cnts[t % 3] += 1;
+            t /= 3;
+            for (uint32_t trit = 0; trit < 3; ++trit) {
+                lut.table[trit][k][tryte] = cnts[trit];
+            }
+        }
+    }
+    return lut;
+}
+
+// SELECT_LUT[t][n][tryte] holds the position of the (n+1)-th occurrence of trit t in the tryte,
+// or 5 if it does not exist.
+struct select_lut_type {
+    uint8_t table[3][5][243];
+};
+
+constexpr select_lut_type make_select_lut() {
+    select_lut_type lut{};
+    for (uint32_t trit = 0; trit < 3; ++trit) {
+        for (uint32_t tryte = 0; tryte < 243; ++tryte) {
+            for (uint32_t n = 0; n < 5; ++n) {
+                lut.table[trit][n][tryte] = 5;
+            }
+            uint32_t t = tryte;
+            uint32_t n = 0;
+            for (uint32_t k = 0; k < 5; ++k) {
+                if (t % 3 == trit) {
+                    lut.table[trit][n++][tryte] = uint8_t(k);
+                }
+                t /= 3;
+            }
+        }
+    }
+    return lut;
+}
+
+// PRED_COUNT_LUT[m][k][tryte] holds the number of trits in the bit mask m (e.g., 0b011 for 0s and 1s)
+// in the first k+1 trits of the tryte, and PRED_SELECT_LUT[m][n][tryte] holds the position of the
+// (n+1)-th such trit in the tryte, or 5 if it does not exist.
+struct pred_lut_type {
+    uint8_t count[8][5][243];
+    uint8_t select[8][5][243];
+};
+
+constexpr pred_lut_type make_pred_lut() {
+    pred_lut_type lut{};
+    for (uint32_t mask = 0; mask < 8; ++mask) {
+        for (uint32_t tryte = 0; tryte < 243; ++tryte) {
+            for (uint32_t n = 0; n < 5; ++n) {
+                lut.select[mask][n][tryte] = 5;
+            }
+            uint32_t t = tryte;
+            uint8_t cnt = 0;
+            for (uint32_t k = 0; k < 5; ++k) {
+                if (mask >> (t % 3) & 1) {
+                    lut.select[mask][cnt++][tryte] = uint8_t(k);
+                }
+                lut.count[mask][k][tryte] = cnt;
+                t /= 3;
+            }
+        }
+    }
+    return lut;
+}
+
+// OCCUR_LUT[t][tryte] holds the bit mask of the positions of trit t in the tryte, e.g., 0b00101 if
+// the first and third trits are t.
+struct occur_lut_type {
+    uint8_t table[3][243];
+};
+
+constexpr occur_lut_type make_occur_lut() {
+    occur_lut_type lut{};
+    for (uint32_t tryte = 0; tryte < 243; ++tryte) {
+        uint32_t t = tryte;
+        for (uint32_t k = 0; k < 5; ++k) {
+            lut.table[t % 3][tryte] |= uint8_t(1 << k);
+            t /= 3;
+        }
+    }
+    return lut;
+}
+
+// EXPAND_LUT[tryte] holds the five trits of the tryte in the lower five bytes, from the first one.
+struct expand_lut_type {
+    uint64_t table[243];
+};
+
+constexpr expand_lut_type make_expand_lut() {
+    expand_lut_type lut{};
+    for (uint32_t tryte = 0; tryte < 243; ++tryte) {
+        uint32_t t = tryte;
+        uint64_t word = 0;
+        for (uint32_t k = 0; k < 5; ++k) {
+            word |= uint64_t(t % 3) << (k * 8);
+            t /= 3;
+        }
+        lut.table[tryte] = word;
+    }
+    return lut;
+}
+
+// The tables are kept as static members of a class template so that they are defined only once.
+template <class = void>
+struct tryte_luts {
+    static constexpr fused_lut_type FUSED = make_fused_lut();
+    static constexpr count_lut_type COUNT = make_count_lut();
+    static constexpr select_lut_type SELECT = make_select_lut();
+    static constexpr expand_lut_type EXPAND = make_expand_lut();
+    static constexpr pred_lut_type PRED = make_pred_lut();
+    static constexpr occur_lut_type OCCUR = make_occur_lut();
+};
+
+template <class Dummy>
+constexpr fused_lut_type tryte_luts<Dummy>::FUSED;
+template <class Dummy>
+constexpr count_lut_type tryte_luts<Dummy>::COUNT;
+template <class Dummy>
+constexpr select_lut_type tryte_luts<Dummy>::SELECT;
+template <class Dummy>
+constexpr expand_lut_type tryte_luts<Dummy>::EXPAND;
+template <class Dummy>
+constexpr pred_lut_type tryte_luts<Dummy>::PRED;
+template <class Dummy>
+constexpr occur_lut_type tryte_luts<Dummy>::OCCUR;
+
+}  // namespace detail
+}  // namespace succinctrits
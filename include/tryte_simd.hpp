@@ -0,0 +1,513 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "cpu_dispatch.hpp"
+#include "tryte_lut.hpp"
+
+#ifdef SUCCINCTRITS_USE_SIMD
+#include <immintrin.h>
+#endif
+
+namespace succinctrits {
+namespace detail {
+
+// Kernels of an ISA, chosen once at startup (see detect_isa()) or by set_isa(). The entries are
+// nullptr for the scalar ISA, for which the callers run their own inlined scalar code.
+struct tryte_kernels {
+    isa id = isa::scalar;
+    // Returns the number of Trit in the first num_trits (< 80) trits of the 16 trytes at ptr.
+    uint64_t (*count_trits[3])(const uint8_t* ptr, uint64_t num_trits) = {nullptr, nullptr, nullptr};
+    // Returns the offset of the tryte including the n-th (1-origin) occurrence of Trit in the 16
+    // trytes at ptr, and updates n to the rank (1-origin) of the occurrence in the tryte.
+    // The occurrence must exist in the trytes.
+    uint64_t (*select_tryte[3])(const uint8_t* ptr, uint64_t& n) = {nullptr, nullptr, nullptr};
+    // Returns the number of values no more than x in the array of length len.
+    uint64_t (*count_le_u16)(const uint16_t* values, uint64_t len, uint16_t x) = nullptr;
+    // Packs trits[0..num_trytes*5) into trytes[0..num_trytes), and returns false if any trit is 3
+    // or more.
+    bool (*pack_trytes)(const uint8_t* trits, uint64_t num_trytes, uint8_t* trytes) = nullptr;
+    // Unpacks trytes[0..num_trytes) into trits[0..num_trytes*5).
+    void (*unpack_trytes)(const uint8_t* trytes, uint64_t num_trytes, uint8_t* trits) = nullptr;
+};
+
+// Returns the pointer to 16 trytes from position pos, copied to buf with zero padding if the array
+// ends before them.
+inline const uint8_t* get_16_trytes(const uint8_t* trytes, uint64_t size, uint64_t pos, uint8_t* buf) {
+    if (pos + 16 <= size) {
+        return trytes + pos;
+    }
+    std::memset(buf, 0, 16);
+    std::memcpy(buf, trytes + pos, size - pos);
+    return buf;
+}
+
+#ifdef SUCCINCTRITS_USE_SIMD
+
+// Shuffles and multipliers for the vectorized packing and unpacking, generated at compile time.
+//  - unpack_shuffle[c][m] is the tryte of the (16c+m)-th trit in 16 trytes,
+//  - unpack_mul[c][m] is 65536 / 3^d rounded up, where d is the digit of the trit in the tryte, so
+//    that the 16-bit mulhi by it is the exact division by 3^d for bytes (except d = 0, which is
+//    kept by unpack_keep instead), and
+//  - pack_out[k] moves the bytes 0 and 8 to the bytes 2k and 2k+1.
+struct simd_lut_type {
+    uint8_t unpack_shuffle[5][16];
+    uint16_t unpack_mul[5][16];
+    uint16_t unpack_keep[5][16];
+    uint8_t pack_out[8][16];
+};
+
+constexpr simd_lut_type make_simd_lut() {
+    simd_lut_type lut{};
+    const uint16_t muls[5] = {0, 21846, 7282, 2428, 810};
+    for (uint32_t c = 0; c < 5; ++c) {
+        for (uint32_t m = 0; m < 16; ++m) {
+            const uint32_t g = 16 * c + m;
+            lut.unpack_shuffle[c][m] = uint8_t(g / 5);
+            lut.unpack_mul[c][m] = muls[g % 5];
+            lut.unpack_keep[c][m] = g % 5 == 0 ? 0xFFFF : 0;
+        }
+    }
+    for (uint32_t k = 0; k < 8; ++k) {
+        for (uint32_t m = 0; m < 16; ++m) {
+            lut.pack_out[k][m] = 0x80;
+        }
+        lut.pack_out[k][2 * k] = 0;
+        lut.pack_out[k][2 * k + 1] = 8;
+    }
+    return lut;
+}
+
+template <class = void>
+struct simd_luts {
+    static constexpr simd_lut_type TABLE = make_simd_lut();
+};
+
+template <class Dummy>
+constexpr simd_lut_type simd_luts<Dummy>::TABLE;
+
+// Scalar tails of the bulk kernels
+inline bool pack_trytes_tail(const uint8_t* trits, uint64_t num_trytes, uint8_t* trytes) {
+    uint8_t max = 0;
+    for (uint64_t j = 0; j < num_trytes; ++j, trits += 5) {
+        max = std::max({max, trits[0], trits[1], trits[2], trits[3], trits[4]});
+        trytes[j] = uint8_t(trits[0] + 3 * trits[1] + 9 * trits[2] + 27 * trits[3] + 81 * trits[4]);
+    }
+    return max < 3;
+}
+inline void unpack_trytes_tail(const uint8_t* trytes, uint64_t num_trytes, uint8_t* trits) {
+    for (uint64_t j = 0; j < num_trytes; ++j, trits += 5) {
+        std::memcpy(trits, &tryte_luts<>::EXPAND.table[trytes[j]], 5);
+    }
+}
+
+// The counting kernels extract the base-3 digits of the trytes in 16-bit lanes by dividing them by
+// 3 five times, where x / 3 is computed as (x * 21846) >> 16, which is exact for x < 256.
+
+// ---------------- SSE4.2 ----------------
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_SSE42 inline __m128i sse42_count_half(__m128i x, __m128i lim, __m128i pos) {
+    const __m128i div3 = _mm_set1_epi16(21846);
+    const __m128i target = _mm_set1_epi16(Trit);
+
+    __m128i acc = _mm_setzero_si128();
+    for (int d = 0; d < 5; ++d) {
+        const __m128i q = _mm_mulhi_epu16(x, div3);
+        const __m128i digit = _mm_sub_epi16(x, _mm_add_epi16(q, _mm_add_epi16(q, q)));
+        const __m128i in = _mm_cmpgt_epi16(lim, pos);  // 5 * lane + d < num_trits
+        acc = _mm_sub_epi16(acc, _mm_and_si128(_mm_cmpeq_epi16(digit, target), in));
+        lim = _mm_sub_epi16(lim, _mm_set1_epi16(1));
+        x = q;
+    }
+    return acc;
+}
+
+// Returns the numbers of Trit in the 16 trytes, in 8-bit lanes. Only the first num_trits trits are
+// counted.
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_SSE42 inline __m128i sse42_count_per_tryte(__m128i bytes, uint64_t num_trits) {
+    const __m128i lim = _mm_set1_epi16(int16_t(num_trits));
+    const __m128i acc_lo = sse42_count_half<Trit>(  //
+        _mm_cvtepu8_epi16(bytes), lim, _mm_setr_epi16(0, 5, 10, 15, 20, 25, 30, 35));
+    const __m128i acc_hi = sse42_count_half<Trit>(  //
+        _mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8)), lim, _mm_setr_epi16(40, 45, 50, 55, 60, 65, 70, 75));
+    return _mm_packus_epi16(acc_lo, acc_hi);
+}
+
+// Returns the offset of the tryte whose prefix sum of cnts reaches n, updating n as select_tryte.
+SUCCINCTRITS_TARGET_SSE42 inline uint64_t sse42_select_in_counts(__m128i sums, uint64_t& n) {
+    sums = _mm_add_epi8(sums, _mm_slli_si128(sums, 1));
+    sums = _mm_add_epi8(sums, _mm_slli_si128(sums, 2));
+    sums = _mm_add_epi8(sums, _mm_slli_si128(sums, 4));
+    sums = _mm_add_epi8(sums, _mm_slli_si128(sums, 8));
+
+    // The prefix sums are at most 80, so the signed comparison works.
+    const __m128i found = _mm_cmpgt_epi8(sums, _mm_set1_epi8(int8_t(n - 1)));
+    const uint32_t mask = uint32_t(_mm_movemask_epi8(found));
+    const uint64_t j = uint64_t(__builtin_ctz(mask));
+
+    if (j != 0) {
+        alignas(16) uint8_t buf[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(buf), sums);
+        n -= buf[j - 1];
+    }
+    return j;
+}
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_SSE42 uint64_t sse42_count_trits(const uint8_t* ptr, uint64_t num_trits) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    const __m128i sums = _mm_sad_epu8(sse42_count_per_tryte<Trit>(bytes, num_trits), _mm_setzero_si128());
+    return uint64_t(_mm_cvtsi128_si32(sums)) + uint64_t(_mm_extract_epi16(sums, 4));
+}
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_SSE42 uint64_t sse42_select_tryte(const uint8_t* ptr, uint64_t& n) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    return sse42_select_in_counts(sse42_count_per_tryte<Trit>(bytes, 80), n);
+}
+
+SUCCINCTRITS_TARGET_SSE42 inline uint64_t sse42_count_le_u16(const uint16_t* values, uint64_t len, uint16_t x) {
+    uint64_t cnt = 0;
+    uint64_t i = 0;
+    const __m128i xs = _mm_set1_epi16(int16_t(x));
+    for (; i + 8 <= len; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        const __m128i le = _mm_cmpeq_epi16(_mm_min_epu16(v, xs), v);
+        cnt += uint64_t(__builtin_popcount(uint32_t(_mm_movemask_epi8(le)))) / 2;
+    }
+    for (; i < len; ++i) {
+        cnt += values[i] <= x;
+    }
+    return cnt;
+}
+
+// Packs two trytes from the ten trits at ptr (reading 16 bytes) into the bytes 0 and 8.
+// The trits are moved to the lower five bytes of each 64-bit lane, multiplied by 3^d and summed up
+// by maddubs and madd.
+SUCCINCTRITS_TARGET_SSE42 inline __m128i sse42_pack_pair(__m128i bytes, __m128i& max) {
+    const __m128i in = _mm_setr_epi8(0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, -1, -1, -1);
+    const __m128i weights = _mm_setr_epi8(1, 3, 9, 27, 81, 0, 0, 0, 1, 3, 9, 27, 81, 0, 0, 0);
+    const __m128i trits = _mm_shuffle_epi8(bytes, in);
+    max = _mm_max_epu8(max, trits);
+    __m128i x = _mm_madd_epi16(_mm_maddubs_epi16(trits, weights), _mm_set1_epi16(1));
+    return _mm_add_epi32(x, _mm_srli_epi64(x, 32));
+}
+
+// Returns true if every byte of max is less than 3.
+SUCCINCTRITS_TARGET_SSE42 inline bool sse42_all_lt3(__m128i max) {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(max, _mm_set1_epi8(2)), max)) == 0xFFFF;
+}
+
+SUCCINCTRITS_TARGET_SSE42 inline bool sse42_pack_trytes(const uint8_t* trits, uint64_t num_trytes, uint8_t* trytes) {
+    const auto& lut = simd_luts<>::TABLE;
+    __m128i max = _mm_setzero_si128();
+    uint64_t j = 0;
+    for (; j + 18 <= num_trytes; j += 16) {  // the last load reads 6 bytes beyond the 16 trytes
+        __m128i acc = _mm_setzero_si128();
+        for (uint64_t k = 0; k < 8; ++k) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(trits + j * 5 + k * 10));
+            const __m128i out = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.pack_out[k]));
+            acc = _mm_or_si128(acc, _mm_shuffle_epi8(sse42_pack_pair(bytes, max), out));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(trytes + j), acc);
+    }
+    const bool valid = pack_trytes_tail(trits + j * 5, num_trytes - j, trytes + j);
+    return sse42_all_lt3(max) && valid;
+}
+
+// Unpacks 16 trits of step c (i.e., the (16c)-th to (16c+15)-th ones) from the 16 trytes.
+SUCCINCTRITS_TARGET_SSE42 inline __m128i sse42_unpack_step(__m128i trytes, uint64_t c) {
+    const auto& lut = simd_luts<>::TABLE;
+    const __m128i div3 = _mm_set1_epi16(21846);
+    const __m128i bytes =
+        _mm_shuffle_epi8(trytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.unpack_shuffle[c])));
+    __m128i halves[2] = {_mm_cvtepu8_epi16(bytes), _mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8))};
+    for (uint64_t h = 0; h < 2; ++h) {
+        const __m128i mul = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.unpack_mul[c] + h * 8));
+        const __m128i keep = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.unpack_keep[c] + h * 8));
+        const __m128i q = _mm_or_si128(_mm_mulhi_epu16(halves[h], mul), _mm_and_si128(halves[h], keep));
+        const __m128i q3 = _mm_mulhi_epu16(q, div3);
+        halves[h] = _mm_sub_epi16(q, _mm_add_epi16(q3, _mm_add_epi16(q3, q3)));
+    }
+    return _mm_packus_epi16(halves[0], halves[1]);
+}
+
+SUCCINCTRITS_TARGET_SSE42 inline void sse42_unpack_trytes(const uint8_t* trytes, uint64_t num_trytes, uint8_t* trits) {
+    uint64_t j = 0;
+    for (; j + 16 <= num_trytes; j += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(trytes + j));
+        for (uint64_t c = 0; c < 5; ++c) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(trits + j * 5 + c * 16), sse42_unpack_step(bytes, c));
+        }
+    }
+    unpack_trytes_tail(trytes + j, num_trytes - j, trits + j * 5);
+}
+
+// ---------------- AVX2 ----------------
+
+// Returns the numbers of Trit in the 16 trytes, in 16-bit lanes. Only the first num_trits trits are
+// counted.
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_AVX2 inline __m256i avx2_count_per_tryte(__m128i bytes, uint64_t num_trits) {
+    const __m256i pos = _mm256_setr_epi16(0, 5, 10, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 65, 70, 75);
+    const __m256i div3 = _mm256_set1_epi16(21846);
+    const __m256i target = _mm256_set1_epi16(Trit);
+
+    __m256i x = _mm256_cvtepu8_epi16(bytes);
+    __m256i lim = _mm256_set1_epi16(int16_t(num_trits));
+    __m256i acc = _mm256_setzero_si256();
+
+    for (int d = 0; d < 5; ++d) {
+        const __m256i q = _mm256_mulhi_epu16(x, div3);
+        const __m256i digit = _mm256_sub_epi16(x, _mm256_add_epi16(q, _mm256_add_epi16(q, q)));
+        const __m256i in = _mm256_cmpgt_epi16(lim, pos);  // 5 * lane + d < num_trits
+        acc = _mm256_sub_epi16(acc, _mm256_and_si256(_mm256_cmpeq_epi16(digit, target), in));
+        lim = _mm256_sub_epi16(lim, _mm256_set1_epi16(1));
+        x = q;
+    }
+    return acc;
+}
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_AVX2 inline __m128i avx2_count_per_tryte_u8(__m128i bytes, uint64_t num_trits) {
+    const __m256i acc = avx2_count_per_tryte<Trit>(bytes, num_trits);
+    return _mm_packus_epi16(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+}
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_AVX2 uint64_t avx2_count_trits(const uint8_t* ptr, uint64_t num_trits) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    const __m128i sums = _mm_sad_epu8(avx2_count_per_tryte_u8<Trit>(bytes, num_trits), _mm_setzero_si128());
+    return uint64_t(_mm_cvtsi128_si32(sums)) + uint64_t(_mm_extract_epi16(sums, 4));
+}
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_AVX2 uint64_t avx2_select_tryte(const uint8_t* ptr, uint64_t& n) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    return sse42_select_in_counts(avx2_count_per_tryte_u8<Trit>(bytes, 80), n);
+}
+
+SUCCINCTRITS_TARGET_AVX2 inline uint64_t avx2_count_le_u16(const uint16_t* values, uint64_t len, uint16_t x) {
+    uint64_t cnt = 0;
+    uint64_t i = 0;
+    const __m256i xs = _mm256_set1_epi16(int16_t(x));
+    for (; i + 16 <= len; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        const __m256i le = _mm256_cmpeq_epi16(_mm256_min_epu16(v, xs), v);
+        cnt += uint64_t(__builtin_popcount(uint32_t(_mm256_movemask_epi8(le)))) / 2;
+    }
+    return cnt + sse42_count_le_u16(values + i, len - i, x);
+}
+
+SUCCINCTRITS_TARGET_AVX2 inline bool avx2_pack_trytes(const uint8_t* trits, uint64_t num_trytes, uint8_t* trytes) {
+    const auto& lut = simd_luts<>::TABLE;
+    const __m256i in = _mm256_setr_epi8(0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, -1, -1, -1,  //
+                                        0, 1, 2, 3, 4, -1, -1, -1, 5, 6, 7, 8, 9, -1, -1, -1);
+    const __m256i weights = _mm256_setr_epi8(1, 3, 9, 27, 81, 0, 0, 0, 1, 3, 9, 27, 81, 0, 0, 0,  //
+                                             1, 3, 9, 27, 81, 0, 0, 0, 1, 3, 9, 27, 81, 0, 0, 0);
+    __m256i max = _mm256_setzero_si256();
+    uint64_t j = 0;
+    for (; j + 18 <= num_trytes; j += 16) {  // the last load reads 6 bytes beyond the 16 trytes
+        // The lanes 0 and 1 pack the trytes 4k, 4k+1 and 4k+2, 4k+3, respectively.
+        __m256i acc = _mm256_setzero_si256();
+        for (uint64_t k = 0; k < 4; ++k) {
+            const uint8_t* ptr = trits + j * 5 + k * 20;
+            const __m256i bytes =
+                _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))),
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 10)), 1);
+            const __m256i t = _mm256_shuffle_epi8(bytes, in);
+            max = _mm256_max_epu8(max, t);
+            __m256i x = _mm256_madd_epi16(_mm256_maddubs_epi16(t, weights), _mm256_set1_epi16(1));
+            x = _mm256_add_epi32(x, _mm256_srli_epi64(x, 32));
+            const __m128i out = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.pack_out[k]));
+            acc = _mm256_or_si256(acc, _mm256_shuffle_epi8(x, _mm256_broadcastsi128_si256(out)));
+        }
+        // (0,1),(4,5),(8,9),(12,13) and (2,3),(6,7),(10,11),(14,15) are interleaved.
+        const __m128i packed = _mm_unpacklo_epi16(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(trytes + j), packed);
+    }
+    const __m128i max_128 = _mm_max_epu8(_mm256_castsi256_si128(max), _mm256_extracti128_si256(max, 1));
+    const bool valid = pack_trytes_tail(trits + j * 5, num_trytes - j, trytes + j);
+    return sse42_all_lt3(max_128) && valid;
+}
+
+// Unpacks 16 trits of step c as sse42_unpack_step() in a single 256-bit vector.
+SUCCINCTRITS_TARGET_AVX2 inline __m128i avx2_unpack_step(__m128i trytes, uint64_t c) {
+    const auto& lut = simd_luts<>::TABLE;
+    const __m128i bytes =
+        _mm_shuffle_epi8(trytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.unpack_shuffle[c])));
+    const __m256i x = _mm256_cvtepu8_epi16(bytes);
+    const __m256i mul = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lut.unpack_mul[c]));
+    const __m256i keep = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lut.unpack_keep[c]));
+    const __m256i q = _mm256_or_si256(_mm256_mulhi_epu16(x, mul), _mm256_and_si256(x, keep));
+    const __m256i q3 = _mm256_mulhi_epu16(q, _mm256_set1_epi16(21846));
+    const __m256i digits = _mm256_sub_epi16(q, _mm256_add_epi16(q3, _mm256_add_epi16(q3, q3)));
+    return _mm_packus_epi16(_mm256_castsi256_si128(digits), _mm256_extracti128_si256(digits, 1));
+}
+
+SUCCINCTRITS_TARGET_AVX2 inline void avx2_unpack_trytes(const uint8_t* trytes, uint64_t num_trytes, uint8_t* trits) {
+    uint64_t j = 0;
+    for (; j + 16 <= num_trytes; j += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(trytes + j));
+        for (uint64_t c = 0; c < 5; ++c) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(trits + j * 5 + c * 16), avx2_unpack_step(bytes, c));
+        }
+    }
+    unpack_trytes_tail(trytes + j, num_trytes - j, trits + j * 5);
+}
+
+// ---------------- AVX-512BW ----------------
+
+// Counts with mask registers instead of accumulating the comparisons.
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_AVX512BW uint64_t avx512bw_count_trits(const uint8_t* ptr, uint64_t num_trits) {
+    const __m256i pos = _mm256_setr_epi16(0, 5, 10, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 65, 70, 75);
+    const __m256i div3 = _mm256_set1_epi16(21846);
+    const __m256i target = _mm256_set1_epi16(Trit);
+
+    __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+    __m256i lim = _mm256_set1_epi16(int16_t(num_trits));
+    uint32_t cnt = 0;
+
+    for (int d = 0; d < 5; ++d) {
+        const __m256i q = _mm256_mulhi_epu16(x, div3);
+        const __m256i digit = _mm256_sub_epi16(x, _mm256_add_epi16(q, _mm256_add_epi16(q, q)));
+        const __mmask16 in = _mm256_cmpgt_epi16_mask(lim, pos);  // 5 * lane + d < num_trits
+        cnt += __builtin_popcount(_mm256_mask_cmpeq_epi16_mask(in, digit, target));
+        lim = _mm256_sub_epi16(lim, _mm256_set1_epi16(1));
+        x = q;
+    }
+    return cnt;
+}
+
+template <uint8_t Trit>
+SUCCINCTRITS_TARGET_AVX512BW uint64_t avx512bw_select_tryte(const uint8_t* ptr, uint64_t& n) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    return sse42_select_in_counts(avx2_count_per_tryte_u8<Trit>(bytes, 80), n);
+}
+
+SUCCINCTRITS_TARGET_AVX512BW inline uint64_t avx512bw_count_le_u16(const uint16_t* values, uint64_t len, uint16_t x) {
+    uint64_t cnt = 0;
+    uint64_t i = 0;
+    const __m512i xs = _mm512_set1_epi16(int16_t(x));
+    for (; i + 32 <= len; i += 32) {
+        const __m512i v = _mm512_loadu_si512(values + i);
+        cnt += uint64_t(__builtin_popcount(_mm512_cmple_epu16_mask(v, xs)));
+    }
+    // The rest in a masked load
+    const __mmask32 rest = uint32_t((uint64_t(1) << (len - i)) - 1);
+    const __m512i v = _mm512_maskz_loadu_epi16(rest, values + i);
+    return cnt + uint64_t(__builtin_popcount(_mm512_mask_cmple_epu16_mask(rest, v, xs)));
+}
+
+// Packing is shuffle-bound and the same as the AVX2 one, compiled with the EVEX encoding.
+SUCCINCTRITS_TARGET_AVX512BW inline bool avx512bw_pack_trytes(const uint8_t* trits, uint64_t num_trytes,
+                                                              uint8_t* trytes) {
+    return avx2_pack_trytes(trits, num_trytes, trytes);
+}
+
+// Unpacks 32 trits of steps c and c+1 in a single 512-bit vector.
+SUCCINCTRITS_TARGET_AVX512BW inline __m256i avx512bw_unpack_2steps(__m128i trytes, uint64_t c) {
+    const auto& lut = simd_luts<>::TABLE;
+    const __m128i lo =
+        _mm_shuffle_epi8(trytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.unpack_shuffle[c])));
+    const __m128i hi =
+        _mm_shuffle_epi8(trytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.unpack_shuffle[c + 1])));
+    const __m512i x = _mm512_cvtepu8_epi16(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1));
+    const __m512i mul = _mm512_loadu_si512(lut.unpack_mul[c]);  // the rows c and c+1 are contiguous
+    const __m512i keep = _mm512_loadu_si512(lut.unpack_keep[c]);
+    const __m512i q = _mm512_or_si512(_mm512_mulhi_epu16(x, mul), _mm512_and_si512(x, keep));
+    const __m512i q3 = _mm512_mulhi_epu16(q, _mm512_set1_epi16(21846));
+    // The zero-masking form avoids the uninitialized source of _mm512_cvtepi16_epi8 warned by GCC.
+    const __m512i digits = _mm512_sub_epi16(q, _mm512_add_epi16(q3, _mm512_add_epi16(q3, q3)));
+    return _mm512_maskz_cvtepi16_epi8(~__mmask32(0), digits);
+}
+
+SUCCINCTRITS_TARGET_AVX512BW inline void avx512bw_unpack_trytes(const uint8_t* trytes, uint64_t num_trytes,
+                                                                uint8_t* trits) {
+    uint64_t j = 0;
+    for (; j + 16 <= num_trytes; j += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(trytes + j));
+        uint8_t* out = trits + j * 5;
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), avx512bw_unpack_2steps(bytes, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), avx512bw_unpack_2steps(bytes, 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 64), avx2_unpack_step(bytes, 4));
+    }
+    unpack_trytes_tail(trytes + j, num_trytes - j, trits + j * 5);
+}
+
+#endif
+
+inline tryte_kernels make_kernels(isa x) {
+    tryte_kernels k;
+    k.id = x;
+#ifdef SUCCINCTRITS_USE_SIMD
+    switch (x) {
+        case isa::scalar:
+            break;
+        case isa::sse42:
+            k.count_trits[0] = sse42_count_trits<0>;
+            k.count_trits[1] = sse42_count_trits<1>;
+            k.count_trits[2] = sse42_count_trits<2>;
+            k.select_tryte[0] = sse42_select_tryte<0>;
+            k.select_tryte[1] = sse42_select_tryte<1>;
+            k.select_tryte[2] = sse42_select_tryte<2>;
+            k.count_le_u16 = sse42_count_le_u16;
+            k.pack_trytes = sse42_pack_trytes;
+            k.unpack_trytes = sse42_unpack_trytes;
+            break;
+        case isa::avx2:
+            k.count_trits[0] = avx2_count_trits<0>;
+            k.count_trits[1] = avx2_count_trits<1>;
+            k.count_trits[2] = avx2_count_trits<2>;
+            k.select_tryte[0] = avx2_select_tryte<0>;
+            k.select_tryte[1] = avx2_select_tryte<1>;
+            k.select_tryte[2] = avx2_select_tryte<2>;
+            k.count_le_u16 = avx2_count_le_u16;
+            k.pack_trytes = avx2_pack_trytes;
+            k.unpack_trytes = avx2_unpack_trytes;
+            break;
+        case isa::avx512bw:
+            k.count_trits[0] = avx512bw_count_trits<0>;
+            k.count_trits[1] = avx512bw_count_trits<1>;
+            k.count_trits[2] = avx512bw_count_trits<2>;
+            k.select_tryte[0] = avx512bw_select_tryte<0>;
+            k.select_tryte[1] = avx512bw_select_tryte<1>;
+            k.select_tryte[2] = avx512bw_select_tryte<2>;
+            k.count_le_u16 = avx512bw_count_le_u16;
+            k.pack_trytes = avx512bw_pack_trytes;
+            k.unpack_trytes = avx512bw_unpack_trytes;
+            break;
+    }
+#endif
+    return k;
+}
+
+// Returns the kernels in use, which are chosen by detect_isa() at the first call.
+inline tryte_kernels& get_kernels() {
+    static tryte_kernels kernels = make_kernels(detect_isa());
+    return kernels;
+}
+
+}  // namespace detail
+
+// Returns the ISA of the kernels in use.
+inline isa get_isa() {
+    return detail::get_kernels().id;
+}
+
+// Forces the kernels of ISA x, e.g., for tests and benchmark comparisons. Returns false, keeping the
+// current ones, if the CPU does not support x. It must not be called during queries on other threads.
+inline bool set_isa(isa x) {
+    if (!is_supported(x)) {
+        return false;
+    }
+    detail::get_kernels() = detail::make_kernels(x);
+    return true;
+}
+
+}  // namespace succinctrits
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "fused_rs_support.hpp"
+#include "trit_vector.hpp"
+
+namespace succinctrits {
+
+// Ternary wavelet matrix on integers less than an alphabet size sigma.
+//
+// The integers are seen as ceil(log3(sigma)) base-3 digits from the most significant one, and each
+// level keeps a digit of every integer in a trit_vector with fused_rs_support. The integers are
+// stably sorted by the digit for the next level, i.e., 0s first, then 1s and 2s.
+// Queries take one rank_all (or select) per level, which is 37% fewer levels than a binary one.
+class wavelet_matrix {
+  public:
+    wavelet_matrix() = default;
+
+    template <class Iterator>
+    wavelet_matrix(Iterator it, uint64_t num, uint64_t sigma) {
+        build(it, num, sigma);
+    }
+
+    // The levels refer to each other by pointers, so that they are not copied but can be moved.
+    wavelet_matrix(const wavelet_matrix&) = delete;
+    wavelet_matrix& operator=(const wavelet_matrix&) = delete;
+    wavelet_matrix(wavelet_matrix&&) = default;
+    wavelet_matrix& operator=(wavelet_matrix&&) = default;
+
+    template <class Iterator>
+    void build(Iterator it, uint64_t num, uint64_t sigma) {
+        assert(sigma != 0);
+
+        m_size = num;
+        m_sigma = sigma;
+        // 3^41 exceeds 2^64, so any alphabet size needs at most 41 levels.
+        m_num_levels = 1;
+        for (uint64_t x = 3; x < sigma; x *= 3) {
+            ++m_num_levels;
+            if (UINT64_MAX / 3 < x) {
+                break;
+            }
+        }
+
+        std::vector<uint64_t> values(num), next_values(num);
+        for (uint64_t i = 0; i < num; ++i, ++it) {
+            assert(uint64_t(*it) < sigma);
+            values[i] = *it;
+        }
+
+        m_levels = std::vector<trit_vector>(m_num_levels);
+        m_rs_supports = std::vector<fused_rs_support>(m_num_levels);
+
+        std::vector<uint8_t> digits(num);
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const uint64_t pow3 = get_pow3(m_num_levels - level - 1);
+            uint64_t starts[3] = {0, 0, 0};
+            for (uint64_t i = 0; i < num; ++i) {
+                digits[i] = uint8_t(values[i] / pow3 % 3);
+                ++starts[digits[i]];
+            }
+            starts[2] = starts[0] + starts[1];
+            starts[1] = starts[0];
+            starts[0] = 0;
+            for (uint64_t i = 0; i < num; ++i) {
+                next_values[starts[digits[i]]++] = values[i];
+            }
+            values.swap(next_values);
+
+            m_levels[level].build_from_span(digits.data(), num);
+            m_rs_supports[level].build(&m_levels[level]);
+        }
+    }
+
+    // Returns the integer at position i.
+    uint64_t access(uint64_t i) const {
+        assert(i < m_size);
+        uint64_t value = 0;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const uint8_t d = m_levels[level][i];
+            i = get_start(level, d) + m_rs_supports[level].rank_all(i)[d];
+            value = value * 3 + d;
+        }
+        return value;
+    }
+    uint64_t operator[](uint64_t i) const {
+        return access(i);
+    }
+
+    // Returns the number of occurrences of c between positions 0 and i-1, for i <= size().
+    uint64_t rank(uint64_t c, uint64_t i) const {
+        assert(i <= m_size);
+        if (m_sigma <= c) {
+            return 0;
+        }
+        uint64_t beg = 0, end = i;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const uint8_t d = get_digit(c, level);
+            beg = get_start(level, d) + m_rs_supports[level].rank_all(beg)[d];
+            end = get_start(level, d) + m_rs_supports[level].rank_all(end)[d];
+        }
+        return end - beg;
+    }
+
+    // Returns the position of the (n+1)-th occurrence of c, for n < rank(c, size()).
+    uint64_t select(uint64_t c, uint64_t n) const {
+        assert(c < m_sigma);
+        assert(n < rank(c, m_size));
+
+        // The position of the first c in the last level
+        uint64_t beg = 0;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const uint8_t d = get_digit(c, level);
+            beg = get_start(level, d) + m_rs_supports[level].rank_all(beg)[d];
+        }
+
+        uint64_t i = beg + n;
+        for (uint64_t level = m_num_levels; level != 0; --level) {
+            const uint8_t d = get_digit(c, level - 1);
+            i = select_trit(level - 1, d, i - get_start(level - 1, d));
+        }
+        return i;
+    }
+
+    // Returns the (k+1)-th smallest integer between positions beg and end-1, for k < end - beg.
+    uint64_t quantile(uint64_t beg, uint64_t end, uint64_t k) const {
+        assert(beg < end && end <= m_size);
+        assert(k < end - beg);
+
+        uint64_t value = 0;
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            const auto beg_ranks = m_rs_supports[level].rank_all(beg);
+            const auto end_ranks = m_rs_supports[level].rank_all(end);
+            uint8_t d = 0;
+            for (; d < 2; ++d) {
+                const uint64_t cnt = end_ranks[d] - beg_ranks[d];
+                if (k < cnt) {
+                    break;
+                }
+                k -= cnt;
+            }
+            beg = get_start(level, d) + beg_ranks[d];
+            end = get_start(level, d) + end_ranks[d];
+            value = value * 3 + d;
+        }
+        return value;
+    }
+
+    // Returns the number of integers in [lo, hi) between positions beg and end-1.
+    uint64_t range_count(uint64_t beg, uint64_t end, uint64_t lo, uint64_t hi) const {
+        assert(beg <= end && end <= m_size);
+        if (hi <= lo) {
+            return 0;
+        }
+        return count_less(beg, end, hi) - count_less(beg, end, lo);
+    }
+
+    uint64_t size() const {
+        return m_size;
+    }
+    uint64_t get_alphabet_size() const {
+        return m_sigma;
+    }
+    uint64_t get_num_levels() const {
+        return m_num_levels;
+    }
+    uint64_t size_in_bytes() const {
+        uint64_t bytes = sizeof(m_size) + sizeof(m_sigma) + sizeof(m_num_levels);
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            bytes += m_levels[level].size_in_bytes() + m_rs_supports[level].size_in_bytes();
+        }
+        return bytes;
+    }
+
+    void save(std::ostream& os) const {
+        os.write(reinterpret_cast<const char*>(&m_size), sizeof(m_size));
+        os.write(reinterpret_cast<const char*>(&m_sigma), sizeof(m_sigma));
+        os.write(reinterpret_cast<const char*>(&m_num_levels), sizeof(m_num_levels));
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            m_levels[level].save(os);
+            m_rs_supports[level].save(os);
+        }
+    }
+    void load(std::istream& is) {
+        is.read(reinterpret_cast<char*>(&m_size), sizeof(m_size));
+        is.read(reinterpret_cast<char*>(&m_sigma), sizeof(m_sigma));
+        is.read(reinterpret_cast<char*>(&m_num_levels), sizeof(m_num_levels));
+        m_levels = std::vector<trit_vector>(m_num_levels);
+        m_rs_supports = std::vector<fused_rs_support>(m_num_levels);
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            m_levels[level].load(is);
+            m_rs_supports[level].load(is);
+            m_rs_supports[level].set_vector(&m_levels[level]);
+        }
+    }
+    // Views the data saved by save() at ptr (8-byte aligned) without copying, and returns the pointer
+    // to the next data. The memory must outlive this object.
+    const uint8_t* map(const uint8_t* ptr) {
+        std::memcpy(&m_size, ptr, sizeof(m_size));
+        ptr += sizeof(m_size);
+        std::memcpy(&m_sigma, ptr, sizeof(m_sigma));
+        ptr += sizeof(m_sigma);
+        std::memcpy(&m_num_levels, ptr, sizeof(m_num_levels));
+        ptr += sizeof(m_num_levels);
+        m_levels = std::vector<trit_vector>(m_num_levels);
+        m_rs_supports = std::vector<fused_rs_support>(m_num_levels);
+        for (uint64_t level = 0; level < m_num_levels; ++level) {
+            ptr = m_levels[level].map(ptr);
+            ptr = m_rs_supports[level].map(ptr);
+            m_rs_supports[level].set_vector(&m_levels[level]);
+        }
+        return ptr;
+    }
+
+  private:
+    uint64_t m_size = 0;
+    uint64_t m_sigma = 0;
+    uint64_t m_num_levels = 0;
+    std::vector<trit_vector> m_levels;
+    std::vector<fused_rs_support> m_rs_supports;
+
+    // Returns 3^k, or UINT64_MAX if it does not fit in 64 bits (i.e., for 41 levels).
+    static uint64_t get_pow3(uint64_t k) {
+        uint64_t x = 1;
+        for (; k != 0; --k) {
+            if (UINT64_MAX / 3 < x) {
+                return UINT64_MAX;
+            }
+            x *= 3;
+        }
+        return x;
+    }
+
+    uint8_t get_digit(uint64_t c, uint64_t level) const {
+        return uint8_t(c / get_pow3(m_num_levels - level - 1) % 3);
+    }
+
+    // Returns the position in the next level where the integers with digit d at the level begin.
+    uint64_t get_start(uint64_t level, uint8_t d) const {
+        const fused_rs_support& rs = m_rs_supports[level];
+        if (d == 0) {
+            return 0;
+        } else if (d == 1) {
+            return rs.get_num_target_trits<0>();
+        }
+        return rs.get_num_target_trits<0>() + rs.get_num_target_trits<1>();
+    }
+
+    uint64_t select_trit(uint64_t level, uint8_t d, uint64_t n) const {
+        const fused_rs_support& rs = m_rs_supports[level];
+        if (d == 0) {
+            return rs.select<0>(n);
+        } else if (d == 1) {
+            return rs.select<1>(n);
+        }
+        return rs.select<2>(n);
+    }
+
+    // Returns the number of integers less than x between positions beg and end-1.
+    uint64_t count_less(uint64_t beg, uint64_t end, uint64_t x) const {
+        if (get_pow3(m_num_levels) <= x) {
+            return end - beg;
+        }
+        uint64_t cnt = 0;
+        for (uint64_t level = 0; level < m_num_levels && beg < end; ++level) {
+            const uint8_t d = get_digit(x, level);
+            const auto beg_ranks = m_rs_supports[level].rank_all(beg);
+            const auto end_ranks = m_rs_supports[level].rank_all(end);
+            for (uint8_t t = 0; t < d; ++t) {
+                cnt += end_ranks[t] - beg_ranks[t];
+            }
+            beg = get_start(level, d) + beg_ranks[d];
+            end = get_start(level, d) + end_ranks[d];
+        }
+        return cnt;
+    }
+};
+
+}  // namespace succinctrits
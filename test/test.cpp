@@ -1,8 +1,27 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <random>
+#include <sstream>
+#include <string>
+#include <thread>
 
+#include <appendable_trit_vector.hpp>
+#include <container.hpp>
+#include <dynamic_trit_vector.hpp>
+#include <fused_rs_support.hpp>
+#include <interleaved_rs_vector.hpp>
+#include <mmap_file.hpp>
+#include <packed_rs_support.hpp>
+#include <rrr_rs_support.hpp>
 #include <rs_support.hpp>
+#include <streaming_builder.hpp>
 #include <trit_vector.hpp>
+#include <wavelet_matrix.hpp>
 
 static constexpr uint64_t NUM_TRITS = 5000000;
 
@@ -18,9 +37,34 @@ std::vector<uint8_t> generate_trits() {
     return trits;
 }
 
-template <uint8_t Trit>
+// Generates trits in which rare_trit appears with probability about 1/ratio
+std::vector<uint8_t> generate_sparse_trits(uint64_t num_trits, uint8_t rare_trit, uint32_t ratio) {
+    std::default_random_engine engine(13);
+    std::uniform_int_distribution<uint32_t> dist(0, ratio - 1);
+
+    std::vector<uint8_t> trits(num_trits);
+    for (uint64_t i = 0; i < num_trits; ++i) {
+        trits[i] = dist(engine) == 0 ? rare_trit : (rare_trit + 1 + dist(engine) % 2) % 3;
+    }
+    return trits;
+}
+
+// Generates trits in which each trit other than frequent_trit appears with probability about 1/ratio
+std::vector<uint8_t> generate_skewed_trits(uint64_t num_trits, uint8_t frequent_trit, uint32_t ratio) {
+    std::default_random_engine engine(17);
+    std::uniform_int_distribution<uint32_t> dist(0, ratio - 1);
+
+    std::vector<uint8_t> trits(num_trits);
+    for (uint64_t i = 0; i < num_trits; ++i) {
+        const uint32_t x = dist(engine);
+        trits[i] = x < 2 ? (frequent_trit + 1 + x) % 3 : frequent_trit;
+    }
+    return trits;
+}
+
+template <uint8_t Trit, class RSSupport = succinctrits::rs_support<Trit>>
 void test_template(const succinctrits::trit_vector& tv) {
-    succinctrits::rs_support<Trit> tv_rs(&tv);
+    RSSupport tv_rs(&tv);
     for (uint64_t i = 0; i < tv.get_num_trits(); ++i) {
         if (tv[i] != tv_rs[i]) {
             std::cerr << "Error: tv[i] != tv_rs[i] (" << int(tv[i]) << " != " << int(tv_rs[i]) << std::endl;
@@ -35,6 +79,11 @@ void test_template(const succinctrits::trit_vector& tv) {
             std::cerr << "Error: Rank(" << i << ") = " << r << ", but != " << rank << std::endl;
             return;
         }
+        if (rank != tv_rs.rank_scalar(i)) {
+            std::cerr << "Error: RankScalar(" << i << ") = " << tv_rs.rank_scalar(i) << ", but != " << rank
+                      << std::endl;
+            return;
+        }
         if (tv[i] == Trit) {
             ++rank;
         }
@@ -47,11 +96,1397 @@ void test_template(const succinctrits::trit_vector& tv) {
             std::cerr << "Error: Select(" << n << ") = " << i << ", but Rank(" << i << ") != " << r << std::endl;
             return;
         }
+        if (i != tv_rs.select_scalar(n)) {
+            std::cerr << "Error: SelectScalar(" << n << ") = " << tv_rs.select_scalar(n) << ", but != " << i
+                      << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <uint8_t Trit>
+void test_select_samples(const succinctrits::trit_vector& tv, uint64_t select_sample_rate) {
+    succinctrits::rs_support<Trit> tv_rs(&tv);
+    succinctrits::rs_support<Trit> tv_rs_sampled(&tv, select_sample_rate);
+
+    if (tv_rs.get_num_target_trits() != tv_rs_sampled.get_num_target_trits()) {
+        std::cerr << "Error: tv_rs_sampled.get_num_target_trits() is wrong" << std::endl;
+        return;
+    }
+    for (uint64_t n = 0; n < tv_rs.get_num_target_trits(); ++n) {
+        uint64_t i = tv_rs.select(n);
+        if (i != tv_rs_sampled.select(n) || i != tv_rs_sampled.select_scalar(n)) {
+            std::cerr << "Error: SampledSelect(" << n << ") = " << tv_rs_sampled.select(n) << ", but != " << i
+                      << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+// Checks the parallel construction, select samples and batched queries with other block parameters
+template <uint8_t Trit, class RSSupport>
+void test_block_params(const succinctrits::trit_vector& tv) {
+    const succinctrits::rs_support<Trit> expected(&tv);
+    RSSupport tv_rs;
+    tv_rs.build(&tv, 64, 4);
+
+    if (tv_rs.get_num_target_trits() != expected.get_num_target_trits()) {
+        std::cerr << "Error: tv_rs.get_num_target_trits() != " << expected.get_num_target_trits() << std::endl;
+        return;
+    }
+    for (uint64_t i = 0; i < tv.get_num_trits(); i += 3) {
+        if (tv_rs.rank(i) != expected.rank(i)) {
+            std::cerr << "Error: Rank(" << i << ") = " << tv_rs.rank(i) << ", but != " << expected.rank(i) << std::endl;
+            return;
+        }
+    }
+    std::vector<uint64_t> ns(tv_rs.get_num_target_trits());
+    for (uint64_t n = 0; n < ns.size(); ++n) {
+        ns[n] = n;
+    }
+    std::vector<uint64_t> positions(ns.size());
+    tv_rs.select_batch(ns.data(), ns.size(), positions.data());
+    for (uint64_t n = 0; n < ns.size(); ++n) {
+        if (positions[n] != expected.select(n) || tv_rs.select(n) != expected.select(n)) {
+            std::cerr << "Error: Select(" << n << ") = " << positions[n] << ", but != " << expected.select(n)
+                      << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <uint8_t Trit>
+void test_batch(const succinctrits::trit_vector& tv, uint64_t select_sample_rate) {
+    succinctrits::rs_support<Trit> tv_rs(&tv, select_sample_rate);
+
+    std::default_random_engine engine(7);
+    std::uniform_int_distribution<uint64_t> pos_dist(0, tv.get_num_trits() - 1);
+    std::uniform_int_distribution<uint64_t> n_dist(0, tv_rs.get_num_target_trits() - 1);
+
+    const uint64_t num = 10000 + 7;
+    std::vector<uint64_t> positions(num), ns(num), results(num);
+    std::vector<uint8_t> trits(num);
+    for (uint64_t j = 0; j < num; ++j) {
+        positions[j] = pos_dist(engine);
+        ns[j] = n_dist(engine);
+    }
+
+    tv.access_batch(positions.data(), num, trits.data());
+    for (uint64_t j = 0; j < num; ++j) {
+        if (trits[j] != tv[positions[j]]) {
+            std::cerr << "Error: AccessBatch(" << positions[j] << ") = " << int(trits[j]) << std::endl;
+            return;
+        }
+    }
+    tv_rs.rank_batch(positions.data(), num, results.data());
+    for (uint64_t j = 0; j < num; ++j) {
+        if (results[j] != tv_rs.rank(positions[j])) {
+            std::cerr << "Error: RankBatch(" << positions[j] << ") = " << results[j] << std::endl;
+            return;
+        }
+    }
+    tv_rs.select_batch(ns.data(), num, results.data());
+    for (uint64_t j = 0; j < num; ++j) {
+        if (results[j] != tv_rs.select(ns[j])) {
+            std::cerr << "Error: SelectBatch(" << ns[j] << ") = " << results[j] << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <class Index>
+bool equals_index(const succinctrits::trit_vector& tv, const Index& expected, const Index& actual) {
+    std::default_random_engine engine(11);
+    std::uniform_int_distribution<uint64_t> dist(0, tv.get_num_trits() - 1);
+    for (uint64_t j = 0; j < 10000; ++j) {
+        const uint64_t i = dist(engine);
+        if (expected[i] != actual[i] || expected.rank(i) != actual.rank(i)) {
+            return false;
+        }
+        const uint64_t n = i % expected.get_num_target_trits();
+        if (expected.select(n) != actual.select(n)) {
+            return false;
+        }
+    }
+    return expected.get_num_target_trits() == actual.get_num_target_trits();
+}
+
+template <uint8_t Trit>
+void test_next_prev(const succinctrits::trit_vector& tv, succinctrits::rs_layout layout) {
+    succinctrits::rs_support<Trit> tv_rs(&tv, layout);
+    const uint64_t num_trits = tv.get_num_trits();
+
+    uint64_t expected = num_trits;
+    for (uint64_t i = num_trits + 1; i-- > 0;) {
+        if (i < num_trits && tv[i] == Trit) {
+            expected = i;
+        }
+        if (tv_rs.next(i) != expected) {
+            std::cerr << "Error: Next(" << i << ") = " << tv_rs.next(i) << ", but != " << expected << std::endl;
+            return;
+        }
+    }
+    expected = num_trits;
+    for (uint64_t i = 0; i <= num_trits; ++i) {
+        if (tv_rs.prev(i) != expected) {
+            std::cerr << "Error: Prev(" << i << ") = " << tv_rs.prev(i) << ", but != " << expected << std::endl;
+            return;
+        }
+        if (i < num_trits && tv[i] == Trit) {
+            expected = i;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_stats(const succinctrits::trit_vector& tv) {
+    succinctrits::rs_support<1> tv_rs(&tv);
+    succinctrits::stats& st = succinctrits::stats::get();
+    st.reset();
+
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < tv.get_num_trits(); ++i) {
+        sum += tv[i] + tv_rs.rank(i);
+    }
+    for (uint64_t n = 0; n < tv_rs.get_num_target_trits(); ++n) {
+        sum += tv_rs.select(n);
+    }
+
+    const uint64_t num_trits = tv.get_num_trits();
+    const uint64_t num_selects = tv_rs.get_num_target_trits();
+    if (!succinctrits::stats::enabled()) {
+        if (st.num_access != 0 || st.num_rank != 0 || st.num_select != 0) {
+            std::cerr << "Error: the stats are counted although disabled" << std::endl;
+            return;
+        }
+    } else if (st.num_access != num_trits || st.num_rank != num_trits || st.num_select != num_selects) {
+        std::cerr << "Error: the stats (" << st.num_access << ", " << st.num_rank << ", " << st.num_select
+                  << ") != (" << num_trits << ", " << num_trits << ", " << num_selects << ")" << std::endl;
+        return;
+    } else if (st.rank_scanned_trytes < num_trits || st.select_scanned_trytes < num_selects) {
+        // Every query reads at least one tryte
+        std::cerr << "Error: too few scanned trytes" << std::endl;
+        return;
+    }
+    st.reset();
+
+    std::cerr << (sum != 0 ? "No Problem!" : "Error: sum == 0") << std::endl;
+}
+
+void test_memory_resource(const std::vector<uint8_t>& trits) {
+    succinctrits::trit_vector tv(trits.begin(), trits.size());
+    succinctrits::rs_support<0> tv_rs(&tv, 512);
+    succinctrits::rs_support<2> tv_rs_sparse(&tv, succinctrits::rs_layout::sparse);
+
+    succinctrits::new_delete_resource new_delete;
+    succinctrits::huge_page_resource huge_page;
+    succinctrits::numa_resource numa_interleave;
+    succinctrits::numa_resource numa_local(succinctrits::numa_resource::policy::local);
+    succinctrits::memory_resource* resources[] = {&new_delete, &huge_page, &numa_interleave, &numa_local};
+
+    for (succinctrits::memory_resource* resource : resources) {
+        succinctrits::trit_vector::builder b(resource);
+        b.append(trits.data(), trits.size());
+        succinctrits::trit_vector other_tv;
+        other_tv.build(&b);
+        succinctrits::rs_support<0> other_tv_rs(&other_tv, 512);
+        succinctrits::rs_support<2> other_tv_rs_sparse(&other_tv, succinctrits::rs_layout::sparse);
+        other_tv_rs.relocate(resource);
+        other_tv_rs_sparse.relocate(resource);
+        if (!equals_index(tv, tv_rs, other_tv_rs) || !equals_index(tv, tv_rs_sparse, other_tv_rs_sparse)) {
+            std::cerr << "Error: the relocated index is different" << std::endl;
+            return;
+        }
+
+        // Copies stay in the same resource, and moves keep the memory.
+        succinctrits::trit_vector copied_tv = other_tv;
+        succinctrits::rs_support<0> copied_tv_rs = other_tv_rs;
+        copied_tv_rs.set_vector(&copied_tv);
+        succinctrits::trit_vector moved_tv = std::move(copied_tv);
+        copied_tv_rs.set_vector(&moved_tv);
+        if (!equals_index(tv, tv_rs, copied_tv_rs)) {
+            std::cerr << "Error: the copied index is different" << std::endl;
+            return;
+        }
+
+        std::stringstream ss;
+        moved_tv.save(ss);
+        copied_tv_rs.save(ss);
+        succinctrits::trit_vector loaded_tv;
+        succinctrits::rs_support<0> loaded_tv_rs;
+        loaded_tv.load(ss);
+        loaded_tv_rs.load(ss);
+        loaded_tv_rs.set_vector(&loaded_tv);
+        loaded_tv.relocate(resource);
+        if (!equals_index(tv, tv_rs, loaded_tv_rs)) {
+            std::cerr << "Error: the loaded index is different" << std::endl;
+            return;
+        }
+    }
+    if (huge_page.get_num_huge_pages() + huge_page.get_num_fallbacks() == 0) {
+        std::cerr << "Error: huge_page_resource was not used" << std::endl;
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <uint8_t Trit>
+void test_interleaved(const std::vector<uint8_t>& trits) {
+    succinctrits::interleaved_rs_vector<Trit> irv(trits.begin(), trits.size());
+
+    uint64_t rank = 0;
+    for (uint64_t i = 0; i <= trits.size(); ++i) {
+        if (irv.rank(i) != rank) {
+            std::cerr << "Error: Rank(" << i << ") = " << irv.rank(i) << ", but != " << rank << std::endl;
+            return;
+        }
+        if (i == trits.size()) {
+            break;
+        }
+        if (irv[i] != trits[i]) {
+            std::cerr << "Error: irv[" << i << "] = " << int(irv[i]) << ", but != " << int(trits[i]) << std::endl;
+            return;
+        }
+        if (trits[i] == Trit) {
+            if (irv.select(rank) != i) {
+                std::cerr << "Error: Select(" << rank << ") = " << irv.select(rank) << ", but != " << i << std::endl;
+                return;
+            }
+            ++rank;
+        }
+    }
+    if (irv.get_num_target_trits() != rank) {
+        std::cerr << "Error: irv.get_num_target_trits() != " << rank << std::endl;
+        return;
+    }
+
+    std::stringstream ss;
+    irv.save(ss);
+    succinctrits::huge_page_resource huge_page;  // outliving the vector
+    succinctrits::interleaved_rs_vector<Trit> loaded;
+    loaded.load(ss);
+    loaded.relocate(&huge_page);
+    const std::string buf = ss.str();
+    std::vector<uint64_t> aligned(buf.size() / sizeof(uint64_t) + 1);
+    std::memcpy(aligned.data(), buf.data(), buf.size());
+    succinctrits::interleaved_rs_vector<Trit> mapped;
+    mapped.map(reinterpret_cast<const uint8_t*>(aligned.data()));
+
+    for (uint64_t i = 0; i <= trits.size(); i += 7) {
+        if (loaded.rank(i) != irv.rank(i) || mapped.rank(i) != irv.rank(i)) {
+            std::cerr << "Error: the loaded or mapped rank is different at " << i << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < rank; n += 7) {
+        if (loaded.select(n) != irv.select(n) || mapped.select(n) != irv.select(n)) {
+            std::cerr << "Error: the loaded or mapped select is different at " << n << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_serialization(const succinctrits::trit_vector& tv) {
+    const char* file_name = "test_serialization.idx";
+
+    succinctrits::rs_support<1> tv_rs(&tv, 512);
+    {
+        std::ofstream ofs(file_name);
+        tv.save(ofs);
+        tv_rs.save(ofs);
+    }
+
+    {
+        std::ifstream ifs(file_name);
+        succinctrits::trit_vector other_tv;
+        succinctrits::rs_support<1> other_tv_rs;
+        other_tv.load(ifs);
+        other_tv_rs.load(ifs);
+        other_tv_rs.set_vector(&other_tv);
+
+        if (!equals_index(tv, tv_rs, other_tv_rs)) {
+            std::cerr << "Error: the loaded index is different" << std::endl;
+            std::remove(file_name);
+            return;
+        }
+    }
+
+    {
+        succinctrits::mmap_file mf(file_name);
+        succinctrits::trit_vector other_tv;
+        succinctrits::rs_support<1> other_tv_rs;
+        const uint8_t* ptr = other_tv.map(mf.data());
+        ptr = other_tv_rs.map(ptr);
+        other_tv_rs.set_vector(&other_tv);
+
+        if (ptr != mf.data() + mf.size()) {
+            std::cerr << "Error: the mapped size is different" << std::endl;
+            std::remove(file_name);
+            return;
+        }
+        if (!equals_index(tv, tv_rs, other_tv_rs)) {
+            std::cerr << "Error: the mapped index is different" << std::endl;
+            std::remove(file_name);
+            return;
+        }
+    }
+
+    std::remove(file_name);
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_container(const succinctrits::trit_vector& tv) {
+    const char* file_name = "test_container.idx";
+
+    succinctrits::rs_support<0> tv_rs(&tv);
+    succinctrits::fused_rs_support tv_frs(&tv);
+    succinctrits::container_writer().add(tv).add(tv_rs).add(tv_frs).save(file_name);
+
+    succinctrits::container_reader reader(file_name);
+    if (!reader.contains<succinctrits::rs_support<0>>() || reader.contains<succinctrits::rs_support<1>>() ||
+        !reader.verify()) {
+        std::cerr << "Error: the container sections are wrong" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+
+    succinctrits::trit_vector other_tv;
+    succinctrits::rs_support<0> other_tv_rs;
+    succinctrits::fused_rs_support other_tv_frs;
+    reader.map(&other_tv);
+    reader.map(&other_tv_rs, &other_tv);
+    reader.load(&other_tv_frs, &other_tv);
+
+    if (!equals_index(tv, tv_rs, other_tv_rs)) {
+        std::cerr << "Error: the index in the container is different" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+    for (uint64_t i = 0; i <= tv.get_num_trits(); i += 97) {
+        if (tv_frs.rank_all(i) != other_tv_frs.rank_all(i)) {
+            std::cerr << "Error: the fused index in the container is different" << std::endl;
+            std::remove(file_name);
+            return;
+        }
+    }
+
+    bool thrown = false;
+    try {
+        succinctrits::rs_support<1> missing;
+        reader.load(&missing);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    if (!thrown) {
+        std::cerr << "Error: loading a missing section does not throw" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+
+    // Headers whose bounds overflow 64 bits must be rejected
+    std::string bytes;
+    {
+        std::ifstream ifs(file_name, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    const char* broken_name = "test_container_broken.idx";
+    auto write_broken = [&](uint64_t pos, uint64_t value) {
+        std::string broken = bytes;
+        std::memcpy(&broken[pos], &value, sizeof(value));
+        std::ofstream ofs(broken_name, std::ios::binary);
+        ofs.write(broken.data(), std::streamsize(broken.size()));
+    };
+    auto opens_broken = [&](uint64_t pos, uint64_t value) {
+        write_broken(pos, value);
+        bool opened = true;
+        try {
+            succinctrits::container_reader broken_reader(broken_name);
+        } catch (const std::runtime_error&) {
+            opened = false;
+        }
+        std::remove(broken_name);
+        return opened;
+    };
+    const uint64_t entry_pos = sizeof(succinctrits::container_header);
+    if (opens_broken(offsetof(succinctrits::container_header, num_sections),
+                     UINT64_MAX / sizeof(succinctrits::container_section_entry) + 2) ||
+        opens_broken(entry_pos + offsetof(succinctrits::container_section_entry, size), UINT64_MAX) ||
+        opens_broken(entry_pos + offsetof(succinctrits::container_section_entry, offset),
+                     UINT64_MAX - succinctrits::container_writer::ALIGNMENT + 1)) {
+        std::cerr << "Error: a container with overflowing bounds is opened" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+
+    // A length inside a section past its end must be rejected by map() and load()
+    uint64_t tv_offset = 0;
+    std::memcpy(&tv_offset, &bytes[entry_pos + offsetof(succinctrits::container_section_entry, offset)],
+                sizeof(tv_offset));
+    write_broken(tv_offset, uint64_t(1) << 40);  // number of trytes
+    uint32_t num_thrown = 0;
+    {
+        succinctrits::container_reader broken_reader(broken_name);
+        succinctrits::trit_vector broken_tv;
+        try {
+            broken_reader.map(&broken_tv);
+        } catch (const std::runtime_error&) {
+            ++num_thrown;
+        }
+        try {
+            broken_reader.load(&broken_tv);
+        } catch (const std::runtime_error&) {
+            ++num_thrown;
+        }
+    }
+    std::remove(broken_name);
+    if (num_thrown != 2) {
+        std::cerr << "Error: a container with a broken length is mapped or loaded" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+
+    std::remove(file_name);
+    std::cerr << "No Problem!" << std::endl;
+}
+
+// Returns the bytes written by save()
+template <class T>
+std::string serialize(const T& obj) {
+    std::ostringstream oss;
+    obj.save(oss);
+    return oss.str();
+}
+
+template <uint8_t Trit>
+void test_sparse(const succinctrits::trit_vector& tv) {
+    succinctrits::rs_support<Trit> dense(&tv);
+    succinctrits::rs_support<Trit> sparse(&tv, succinctrits::rs_layout::sparse);
+
+    if (sparse.get_layout() != succinctrits::rs_layout::sparse) {
+        std::cerr << "Error: sparse.get_layout() is wrong" << std::endl;
+        return;
+    }
+    if (sparse.get_num_target_trits() != dense.get_num_target_trits()) {
+        std::cerr << "Error: sparse.get_num_target_trits() is wrong" << std::endl;
+        return;
+    }
+    for (uint64_t i = 0; i < tv.get_num_trits(); ++i) {
+        if (sparse.rank(i) != dense.rank(i)) {
+            std::cerr << "Error: SparseRank(" << i << ") = " << sparse.rank(i) << ", but != " << dense.rank(i)
+                      << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < dense.get_num_target_trits(); ++n) {
+        if (sparse.select(n) != dense.select(n)) {
+            std::cerr << "Error: SparseSelect(" << n << ") = " << sparse.select(n) << ", but != " << dense.select(n)
+                      << std::endl;
+            return;
+        }
+    }
+
+    const uint64_t num = 1000;
+    std::vector<uint64_t> queries(num), results(num);
+    for (uint64_t j = 0; j < num; ++j) {
+        queries[j] = j * 7919 % dense.get_num_target_trits();
+    }
+    sparse.select_batch(queries.data(), num, results.data());
+    for (uint64_t j = 0; j < num; ++j) {
+        if (results[j] != dense.select(queries[j])) {
+            std::cerr << "Error: SparseSelectBatch(" << queries[j] << ") = " << results[j] << std::endl;
+            return;
+        }
+    }
+    sparse.rank_batch(queries.data(), num, results.data());
+    for (uint64_t j = 0; j < num; ++j) {
+        if (results[j] != dense.rank(queries[j])) {
+            std::cerr << "Error: SparseRankBatch(" << queries[j] << ") = " << results[j] << std::endl;
+            return;
+        }
+    }
+
+    succinctrits::rs_support<Trit> loaded;
+    std::istringstream iss(serialize(sparse));
+    loaded.load(iss);
+    loaded.set_vector(&tv);
+    if (loaded.get_layout() != succinctrits::rs_layout::sparse || !equals_index(tv, dense, loaded)) {
+        std::cerr << "Error: loaded sparse rs_support is wrong" << std::endl;
+        return;
+    }
+
+    const bool is_sparse = dense.get_num_target_trits() * succinctrits::rs_support<Trit>::SPARSE_DENSITY <=
+                           tv.get_num_trits();
+    succinctrits::rs_support<Trit> automatic(&tv, succinctrits::rs_layout::automatic);
+    if ((automatic.get_layout() == succinctrits::rs_layout::sparse) != is_sparse) {
+        std::cerr << "Error: rs_layout::automatic chose a wrong layout" << std::endl;
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+// Checks that the streaming builder writes the same container as container_writer.
+void test_streaming_builder(const std::vector<uint8_t>& trits, uint64_t num_trits) {
+    const char* file_name = "test_streaming.idx";
+    const char* expected_name = "test_streaming_expected.idx";
+
+    succinctrits::trit_vector tv(trits.begin(), num_trits);
+    succinctrits::rs_support<0> tv_rs_0(&tv, 64);
+    succinctrits::rs_support<2> tv_rs_2(&tv, 64);
+    succinctrits::container_writer().add(tv).add(tv_rs_0).add(tv_rs_2).save(expected_name);
+
+    auto read_file = [](const char* name) {
+        std::ifstream ifs(name, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    };
+    const std::string expected = read_file(expected_name);
+    std::remove(expected_name);
+
+    {
+        // Appended in pieces not aligned to the trytes nor the chunks
+        succinctrits::streaming_builder b(file_name, 0b101, 64, 1003);
+        for (uint64_t i = 0; i < num_trits; i += 777) {
+            b.append(trits.data() + i, std::min<uint64_t>(777, num_trits - i));
+        }
+        b.finish();
+    }
+    if (read_file(file_name) != expected) {
+        std::cerr << "Error: the streamed container is different" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+    {
+        std::stringstream ss(std::string(trits.begin(), trits.begin() + num_trits));
+        succinctrits::streaming_builder b(file_name, 0b101, 64, 4096);
+        b.append(ss);
+        b.finish();
+    }
+    if (read_file(file_name) != expected) {
+        std::cerr << "Error: the container streamed from std::istream is different" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+
+    succinctrits::container_reader reader(file_name);
+    succinctrits::trit_vector mapped_tv;
+    succinctrits::rs_support<2> mapped_rs_2;
+    reader.map(&mapped_tv);
+    reader.map(&mapped_rs_2, &mapped_tv);
+    if (!reader.verify() || !equals_index(tv, tv_rs_2, mapped_rs_2)) {
+        std::cerr << "Error: the index in the streamed container is different" << std::endl;
+        std::remove(file_name);
+        return;
+    }
+
+    bool thrown = false;
+    try {
+        std::stringstream ss(std::string(trits.begin(), trits.begin() + 10) + "\n");
+        succinctrits::streaming_builder b(file_name, 0b001);
+        b.append(ss);
+        b.finish();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    std::remove(file_name);
+    if (!thrown) {
+        std::cerr << "Error: the invalid input is not detected" << std::endl;
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_parallel_build(const std::vector<uint8_t>& trits, uint64_t num_trits) {
+    succinctrits::trit_vector tv(trits.begin(), num_trits);
+    succinctrits::trit_vector tv_par(trits.begin(), num_trits, 3);
+    if (serialize(tv) != serialize(tv_par)) {
+        std::cerr << "Error: the trit_vector built in parallel is different" << std::endl;
+        return;
+    }
+
+    succinctrits::rs_support<0> tv_rs_0(&tv, 64);
+    succinctrits::rs_support<1> tv_rs_1(&tv, 64);
+    succinctrits::rs_support<2> tv_rs_2(&tv, 64);
+
+    succinctrits::rs_support<0> par_rs_0;
+    succinctrits::rs_support<1> par_rs_1;
+    succinctrits::rs_support<2> par_rs_2;
+    succinctrits::build_rs_supports(&tv_par, &par_rs_0, &par_rs_1, &par_rs_2, 4, 64);
+    if (serialize(tv_rs_0) != serialize(par_rs_0) || serialize(tv_rs_1) != serialize(par_rs_1) ||
+        serialize(tv_rs_2) != serialize(par_rs_2)) {
+        std::cerr << "Error: the rs_support built in parallel is different" << std::endl;
+        return;
+    }
+
+    par_rs_0.build(&tv_par, 64, 2);
+    if (serialize(tv_rs_0) != serialize(par_rs_0)) {
+        std::cerr << "Error: the rs_support<0> built in parallel is different" << std::endl;
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_extract(const succinctrits::trit_vector& tv) {
+    std::default_random_engine engine(7);
+    std::uniform_int_distribution<uint64_t> dist(0, tv.get_num_trits());
+
+    std::vector<uint8_t> trits(tv.get_num_trits());
+    tv.extract(0, tv.get_num_trits(), trits.data());
+    for (uint64_t i = 0; i < tv.get_num_trits(); ++i) {
+        if (trits[i] != tv[i]) {
+            std::cerr << "Error: Extract(0, " << tv.get_num_trits() << ")[" << i << "] = " << int(trits[i])
+                      << std::endl;
+            return;
+        }
+    }
+
+    for (uint64_t q = 0; q < 10000; ++q) {
+        uint64_t beg = dist(engine);
+        const uint64_t end = std::min<uint64_t>(beg + q % 100, tv.get_num_trits());
+        beg = std::min(beg, end);
+        std::vector<uint8_t> buf(end - beg + 1, 3);
+        tv.extract(beg, end, buf.data());
+        for (uint64_t i = beg; i < end; ++i) {
+            if (buf[i - beg] != tv[i]) {
+                std::cerr << "Error: Extract(" << beg << ", " << end << ")[" << i << "] = " << int(buf[i - beg])
+                          << std::endl;
+                return;
+            }
+        }
+        if (buf[end - beg] != 3) {
+            std::cerr << "Error: Extract(" << beg << ", " << end << ") writes beyond the end" << std::endl;
+            return;
+        }
+    }
+
+    uint64_t i = 0;
+    for (uint8_t trit : tv) {
+        if (trit != tv[i]) {
+            std::cerr << "Error: *const_iterator(" << i << ") = " << int(trit) << std::endl;
+            return;
+        }
+        ++i;
+    }
+    if (i != tv.get_num_trits()) {
+        std::cerr << "Error: const_iterator visits " << i << " trits" << std::endl;
+        return;
+    }
+    for (uint64_t q = 0; q < 1000; ++q) {
+        const uint64_t beg = dist(engine);
+        auto it = tv.iterator_at(beg);
+        for (uint64_t j = beg; j < std::min<uint64_t>(beg + 20, tv.get_num_trits()); ++j, ++it) {
+            if (*it != tv[j]) {
+                std::cerr << "Error: *iterator_at(" << beg << ") at " << j << " = " << int(*it) << std::endl;
+                return;
+            }
+        }
     }
 
     std::cerr << "No Problem!" << std::endl;
 }
 
+template <uint8_t Trit>
+void test_occurrences(const succinctrits::trit_vector& tv) {
+    std::default_random_engine engine(11);
+    std::uniform_int_distribution<uint64_t> dist(0, tv.get_num_trits());
+
+    for (uint64_t q = 0; q < 10000; ++q) {
+        uint64_t beg = dist(engine);
+        const uint64_t end = std::min<uint64_t>(beg + (q % 2 == 0 ? q % 23 : q * 7), tv.get_num_trits());
+        beg = std::min(beg, end);
+
+        std::vector<uint64_t> expected;
+        for (uint64_t i = beg; i < end; ++i) {
+            if (tv[i] == Trit) {
+                expected.push_back(i);
+            }
+        }
+        std::vector<uint64_t> positions;
+        tv.for_each_occurrence<Trit>(beg, end, [&](uint64_t i) { positions.push_back(i); });
+        if (positions != expected) {
+            std::cerr << "Error: ForEachOccurrence<" << int(Trit) << ">(" << beg << ", " << end << ") is wrong"
+                      << std::endl;
+            return;
+        }
+        std::vector<uint64_t> found(expected.size() + 1, UINT64_MAX);
+        auto it = tv.find_occurrences<Trit>(beg, end, found.begin());
+        if (it != found.begin() + expected.size() || !std::equal(expected.begin(), expected.end(), found.begin()) ||
+            found.back() != UINT64_MAX) {
+            std::cerr << "Error: FindOccurrences<" << int(Trit) << ">(" << beg << ", " << end << ") is wrong"
+                      << std::endl;
+            return;
+        }
+    }
+
+    std::vector<uint64_t> positions;
+    tv.find_occurrences<Trit>(0, tv.get_num_trits(), std::back_inserter(positions));
+    succinctrits::rs_support<Trit> tv_rs(&tv);
+    if (positions.size() != tv_rs.get_num_target_trits()) {
+        std::cerr << "Error: FindOccurrences<" << int(Trit) << "> finds " << positions.size() << " trits"
+                  << std::endl;
+        return;
+    }
+    for (uint64_t n = 0; n < positions.size(); ++n) {
+        if (positions[n] != tv_rs.select(n)) {
+            std::cerr << "Error: FindOccurrences<" << int(Trit) << ">[" << n << "] = " << positions[n] << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_append(const std::vector<uint8_t>& trits) {
+    succinctrits::trit_vector tv(trits.begin(), trits.size());
+
+    succinctrits::trit_vector tv_span;
+    tv_span.build_from_span(trits.data(), trits.size());
+    if (serialize(tv) != serialize(tv_span)) {
+        std::cerr << "Error: the trit_vector built from the span is different" << std::endl;
+        return;
+    }
+
+    // Mixes push_back and append of various lengths
+    std::default_random_engine engine(11);
+    std::uniform_int_distribution<uint64_t> dist(0, 40);
+    succinctrits::trit_vector::builder b;
+    for (uint64_t i = 0; i < trits.size();) {
+        const uint64_t len = std::min<uint64_t>(dist(engine), trits.size() - i);
+        if (len % 4 == 1) {
+            b.push_back(trits[i++]);
+        } else {
+            b.append(trits.data() + i, len);
+            i += len;
+        }
+    }
+    if (serialize(tv) != serialize(succinctrits::trit_vector(&b))) {
+        std::cerr << "Error: the trit_vector built by append is different" << std::endl;
+        return;
+    }
+
+    // An invalid trit at any position rejects the whole input
+    for (uint64_t bad = 0; bad < 23; ++bad) {
+        succinctrits::trit_vector::builder b_checked;
+        b_checked.append(trits.data(), 3);
+        std::vector<uint8_t> input(trits.begin(), trits.begin() + 23);
+        input[bad] = uint8_t(3 + bad * 11);
+        if (b_checked.try_append(input.data(), input.size())) {
+            std::cerr << "Error: TryAppend accepts " << int(input[bad]) << " at " << bad << std::endl;
+            return;
+        }
+        if (!b_checked.try_append(trits.data() + 3, 20)) {
+            std::cerr << "Error: TryAppend rejects valid trits" << std::endl;
+            return;
+        }
+        succinctrits::trit_vector expected(trits.begin(), 23);
+        if (serialize(expected) != serialize(succinctrits::trit_vector(&b_checked))) {
+            std::cerr << "Error: TryAppend leaves a rejected input" << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_appendable(const std::vector<uint8_t>& trits) {
+    succinctrits::trit_vector tv(trits.begin(), trits.size());
+    succinctrits::fused_rs_support tv_rs(&tv);
+
+    succinctrits::appendable_trit_vector atv;
+    std::atomic<bool> done(false);
+    std::atomic<bool> failed(false);
+
+    // A reader queries the committed prefix while the trits are appended
+    std::thread reader([&]() {
+        std::default_random_engine engine(17);
+        while (!done.load()) {
+            const uint64_t num_trits = atv.get_num_trits();
+            if (num_trits == 0) {
+                continue;
+            }
+            std::uniform_int_distribution<uint64_t> dist(0, num_trits - 1);
+            for (uint64_t q = 0; q < 100; ++q) {
+                const uint64_t i = dist(engine);
+                if (atv[i] != tv[i] || atv.rank_all(i) != tv_rs.rank_all(i)) {
+                    failed = true;
+                }
+                const uint64_t n = atv.rank<1>(i);
+                if (n < atv.get_num_target_trits<1>() && atv.select<1>(n) != tv_rs.select<1>(n)) {
+                    failed = true;
+                }
+            }
+        }
+    });
+
+    std::default_random_engine engine(19);
+    std::uniform_int_distribution<uint64_t> dist(0, 200);
+    for (uint64_t i = 0; i < trits.size();) {
+        const uint64_t len = std::min<uint64_t>(dist(engine), trits.size() - i);
+        if (len % 2 == 0) {
+            atv.append(trits.data() + i, len);
+        } else {
+            for (uint64_t j = i; j < i + len; ++j) {
+                atv.push_back(trits[j]);
+            }
+        }
+        i += len;
+    }
+    done = true;
+    reader.join();
+
+    if (failed) {
+        std::cerr << "Error: a concurrent query on appendable_trit_vector is wrong" << std::endl;
+        return;
+    }
+    if (atv.get_num_appended_trits() != trits.size() ||
+        atv.get_num_trits() != trits.size() / succinctrits::appendable_trit_vector::TRITS_PER_SB *
+                                   succinctrits::appendable_trit_vector::TRITS_PER_SB) {
+        std::cerr << "Error: appendable_trit_vector commits " << atv.get_num_trits() << " trits" << std::endl;
+        return;
+    }
+
+    for (uint64_t i = 0; i <= atv.get_num_trits(); ++i) {
+        if (atv.rank_all(i) != tv_rs.rank_all(i)) {
+            std::cerr << "Error: appendable_trit_vector::rank_all(" << i << ") is wrong" << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < atv.get_num_target_trits<2>(); ++n) {
+        if (atv.select<2>(n) != tv_rs.select<2>(n)) {
+            std::cerr << "Error: appendable_trit_vector::select<2>(" << n << ") is wrong" << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < atv.get_num_target_trits<0>(); ++n) {
+        if (atv.select<0>(n) != tv_rs.select<0>(n)) {
+            std::cerr << "Error: appendable_trit_vector::select<0>(" << n << ") is wrong" << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_dynamic(std::vector<uint8_t> trits) {
+    succinctrits::trit_vector tv(trits.begin(), trits.size());
+    succinctrits::dynamic_trit_vector dtv(tv);
+
+    std::default_random_engine engine(23);
+    std::uniform_int_distribution<uint64_t> dist(0, trits.size() - 1);
+    for (uint64_t q = 0; q < 100000; ++q) {
+        const uint64_t i = dist(engine);
+        const uint8_t t = uint8_t(dist(engine) % 3);
+        trits[i] = t;
+        dtv.set(i, t);
+    }
+    for (uint64_t q = 0; q < 100000; ++q) {
+        const uint8_t t = uint8_t(dist(engine) % 3);
+        trits.push_back(t);
+        dtv.push_back(t);
+    }
+
+    succinctrits::trit_vector expected_tv(trits.begin(), trits.size());
+    succinctrits::fused_rs_support expected(&expected_tv);
+    if (dtv.get_num_trits() != trits.size()) {
+        std::cerr << "Error: dynamic_trit_vector has " << dtv.get_num_trits() << " trits" << std::endl;
+        return;
+    }
+    for (uint64_t i = 0; i <= trits.size(); ++i) {
+        if (i < trits.size() && dtv[i] != trits[i]) {
+            std::cerr << "Error: dynamic_trit_vector[" << i << "] = " << int(dtv[i]) << std::endl;
+            return;
+        }
+        if (dtv.rank_all(i) != expected.rank_all(i)) {
+            std::cerr << "Error: dynamic_trit_vector::rank_all(" << i << ") is wrong" << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < expected.get_num_target_trits<0>(); n += 3) {
+        if (dtv.select<0>(n) != expected.select<0>(n)) {
+            std::cerr << "Error: dynamic_trit_vector::select<0>(" << n << ") is wrong" << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < expected.get_num_target_trits<2>(); n += 3) {
+        if (dtv.select<2>(n) != expected.select<2>(n)) {
+            std::cerr << "Error: dynamic_trit_vector::select<2>(" << n << ") is wrong" << std::endl;
+            return;
+        }
+    }
+
+    // Built only by push_back
+    succinctrits::dynamic_trit_vector dtv_pushed;
+    for (uint64_t i = 0; i < 200000; ++i) {
+        dtv_pushed.push_back(trits[i]);
+    }
+    for (uint64_t i = 0; i <= 200000; i += 7) {
+        if (dtv_pushed.rank_all(i) != expected.rank_all(i)) {
+            std::cerr << "Error: dynamic_trit_vector::rank_all(" << i << ") after push_back is wrong" << std::endl;
+            return;
+        }
+    }
+    for (uint64_t n = 0; n < dtv_pushed.get_num_target_trits<1>(); ++n) {
+        if (dtv_pushed.select<1>(n) != expected.select<1>(n)) {
+            std::cerr << "Error: dynamic_trit_vector::select<1>(" << n << ") after push_back is wrong" << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <class Packing, uint8_t Trit>
+bool test_packed_rs(const succinctrits::packed_trit_vector<Packing>& ptv, const succinctrits::fused_rs_support& expected) {
+    succinctrits::packed_rs_support<Trit, Packing> rs(&ptv);
+    if (rs.get_num_target_trits() != expected.get_num_target_trits<Trit>()) {
+        std::cerr << "Error: packed_rs_support<" << int(Trit) << ", " << Packing::name()
+                  << ">::get_num_target_trits() is wrong" << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < ptv.get_num_trits(); i += 3) {
+        if (rs.rank(i) != expected.rank<Trit>(i)) {
+            std::cerr << "Error: packed_rs_support<" << int(Trit) << ", " << Packing::name() << ">::rank(" << i
+                      << ") is wrong" << std::endl;
+            return false;
+        }
+    }
+    for (uint64_t n = 0; n < rs.get_num_target_trits(); n += 3) {
+        if (rs.select(n) != expected.select<Trit>(n)) {
+            std::cerr << "Error: packed_rs_support<" << int(Trit) << ", " << Packing::name() << ">::select(" << n
+                      << ") is wrong" << std::endl;
+            return false;
+        }
+    }
+
+    succinctrits::packed_rs_support<Trit, Packing> loaded;
+    std::istringstream iss(serialize(rs));
+    loaded.load(iss);
+    loaded.set_vector(&ptv);
+    for (uint64_t n = 0; n < rs.get_num_target_trits(); n += 997) {
+        if (loaded.select(n) != rs.select(n) || loaded.rank(n) != rs.rank(n)) {
+            std::cerr << "Error: loaded packed_rs_support<" << int(Trit) << ", " << Packing::name() << "> is wrong"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Packing>
+void test_packed(const succinctrits::trit_vector& tv) {
+    succinctrits::packed_trit_vector<Packing> ptv(tv.begin(), tv.get_num_trits());
+    succinctrits::fused_rs_support expected(&tv);
+
+    if (ptv.get_num_trits() != tv.get_num_trits()) {
+        std::cerr << "Error: packed_trit_vector<" << Packing::name() << "> has " << ptv.get_num_trits() << " trits"
+                  << std::endl;
+        return;
+    }
+    for (uint64_t i = 0; i < tv.get_num_trits(); ++i) {
+        if (ptv[i] != tv[i]) {
+            std::cerr << "Error: packed_trit_vector<" << Packing::name() << ">[" << i << "] = " << int(ptv[i])
+                      << std::endl;
+            return;
+        }
+    }
+
+    succinctrits::packed_trit_vector<Packing> loaded;
+    std::istringstream iss(serialize(ptv));
+    loaded.load(iss);
+    for (uint64_t i = 0; i < tv.get_num_trits(); i += 101) {
+        if (loaded[i] != tv[i]) {
+            std::cerr << "Error: loaded packed_trit_vector<" << Packing::name() << ">[" << i << "] is wrong"
+                      << std::endl;
+            return;
+        }
+    }
+
+    if (!test_packed_rs<Packing, 0>(ptv, expected) || !test_packed_rs<Packing, 1>(ptv, expected) ||
+        !test_packed_rs<Packing, 2>(ptv, expected)) {
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <uint8_t Trit>
+bool test_rrr_rs(const succinctrits::rrr_trit_vector& rtv, const succinctrits::fused_rs_support& expected) {
+    succinctrits::rrr_rs_support<Trit> rs(&rtv);
+    if (rs.get_num_target_trits() != expected.get_num_target_trits<Trit>()) {
+        std::cerr << "Error: rrr_rs_support<" << int(Trit) << ">::get_num_target_trits() is wrong" << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < rtv.get_num_trits(); ++i) {
+        if (rs.rank(i) != expected.rank<Trit>(i)) {
+            std::cerr << "Error: rrr_rs_support<" << int(Trit) << ">::rank(" << i << ") is wrong" << std::endl;
+            return false;
+        }
+    }
+    for (uint64_t n = 0; n < rs.get_num_target_trits(); ++n) {
+        if (rs.select(n) != expected.select<Trit>(n)) {
+            std::cerr << "Error: rrr_rs_support<" << int(Trit) << ">::select(" << n << ") is wrong" << std::endl;
+            return false;
+        }
+    }
+
+    succinctrits::rrr_rs_support<Trit> loaded;
+    std::istringstream iss(serialize(rs));
+    loaded.load(iss);
+    loaded.set_vector(&rtv);
+    for (uint64_t n = 0; n < rs.get_num_target_trits(); n += 997) {
+        if (loaded.select(n) != rs.select(n) || loaded.rank(n) != rs.rank(n)) {
+            std::cerr << "Error: loaded rrr_rs_support<" << int(Trit) << "> is wrong" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_rrr(const std::vector<uint8_t>& trits) {
+    succinctrits::trit_vector tv(trits.begin(), trits.size());
+    succinctrits::fused_rs_support expected(&tv);
+    succinctrits::rrr_trit_vector rtv(trits.begin(), trits.size());
+
+    if (rtv.get_num_trits() != trits.size()) {
+        std::cerr << "Error: rrr_trit_vector has " << rtv.get_num_trits() << " trits" << std::endl;
+        return;
+    }
+    for (uint64_t i = 0; i < trits.size(); ++i) {
+        if (rtv[i] != trits[i]) {
+            std::cerr << "Error: rrr_trit_vector[" << i << "] = " << int(rtv[i]) << std::endl;
+            return;
+        }
+    }
+
+    succinctrits::rrr_trit_vector loaded;
+    std::istringstream iss(serialize(rtv));
+    loaded.load(iss);
+    for (uint64_t i = 0; i < trits.size(); i += 101) {
+        if (loaded[i] != trits[i]) {
+            std::cerr << "Error: loaded rrr_trit_vector[" << i << "] is wrong" << std::endl;
+            return;
+        }
+    }
+
+    if (!test_rrr_rs<0>(rtv, expected) || !test_rrr_rs<1>(rtv, expected) || !test_rrr_rs<2>(rtv, expected)) {
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+void test_wavelet_matrix(uint64_t num, uint64_t sigma) {
+    std::default_random_engine engine(29);
+    std::uniform_int_distribution<uint64_t> dist(0, sigma - 1);
+    std::vector<uint64_t> values(num);
+    for (uint64_t i = 0; i < num; ++i) {
+        values[i] = dist(engine);
+    }
+
+    succinctrits::wavelet_matrix wm(values.begin(), num, sigma);
+    if (41 < wm.get_num_levels()) {  // 3^41 > 2^64
+        std::cerr << "Error: wavelet_matrix has " << wm.get_num_levels() << " levels" << std::endl;
+        return;
+    }
+    for (uint64_t i = 0; i < num; ++i) {
+        if (wm[i] != values[i]) {
+            std::cerr << "Error: wavelet_matrix[" << i << "] = " << wm[i] << std::endl;
+            return;
+        }
+    }
+
+    // rank and select on every position of a few integers
+    for (uint64_t c : {uint64_t(0), sigma / 2, sigma - 1}) {
+        uint64_t rank = 0;
+        for (uint64_t i = 0; i <= num; ++i) {
+            if (wm.rank(c, i) != rank) {
+                std::cerr << "Error: wavelet_matrix::rank(" << c << ", " << i << ") = " << wm.rank(c, i) << std::endl;
+                return;
+            }
+            if (i < num && values[i] == c) {
+                if (wm.select(c, rank) != i) {
+                    std::cerr << "Error: wavelet_matrix::select(" << c << ", " << rank << ") = " << wm.select(c, rank)
+                              << std::endl;
+                    return;
+                }
+                ++rank;
+            }
+        }
+    }
+
+    std::uniform_int_distribution<uint64_t> pos_dist(0, num);
+    for (uint64_t q = 0; q < 100; ++q) {
+        uint64_t beg = pos_dist(engine), end = pos_dist(engine);
+        if (end < beg) {
+            std::swap(beg, end);
+        }
+        if (beg == end) {
+            continue;
+        }
+        std::vector<uint64_t> sorted(values.begin() + beg, values.begin() + end);
+        std::sort(sorted.begin(), sorted.end());
+        for (uint64_t k = 0; k < sorted.size(); k += sorted.size() / 10 + 1) {
+            if (wm.quantile(beg, end, k) != sorted[k]) {
+                std::cerr << "Error: wavelet_matrix::quantile(" << beg << ", " << end << ", " << k
+                          << ") = " << wm.quantile(beg, end, k) << std::endl;
+                return;
+            }
+        }
+        uint64_t lo = dist(engine), hi = dist(engine) + 1;
+        const uint64_t expected = std::lower_bound(sorted.begin(), sorted.end(), hi) -
+                                  std::min(std::lower_bound(sorted.begin(), sorted.end(), lo),
+                                           std::lower_bound(sorted.begin(), sorted.end(), hi));
+        if (wm.range_count(beg, end, lo, hi) != (lo < hi ? expected : 0)) {
+            std::cerr << "Error: wavelet_matrix::range_count(" << beg << ", " << end << ", " << lo << ", " << hi
+                      << ") = " << wm.range_count(beg, end, lo, hi) << std::endl;
+            return;
+        }
+    }
+
+    succinctrits::wavelet_matrix loaded;
+    std::istringstream iss(serialize(wm));
+    loaded.load(iss);
+    for (uint64_t i = 0; i < num; i += 101) {
+        if (loaded[i] != values[i] || loaded.rank(values[i], i) != wm.rank(values[i], i)) {
+            std::cerr << "Error: loaded wavelet_matrix is wrong" << std::endl;
+            return;
+        }
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <uint8_t Trit>
+bool test_fused_select(const succinctrits::fused_rs_support& tv_rs) {
+    for (uint64_t n = 0; n < tv_rs.get_num_target_trits<Trit>(); ++n) {
+        uint64_t i = tv_rs.select<Trit>(n);
+        if (tv_rs[i] != Trit || tv_rs.rank<Trit>(i) != n) {
+            std::cerr << "Error: Select<" << int(Trit) << ">(" << n << ") = " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_fused(const succinctrits::trit_vector& tv) {
+    succinctrits::fused_rs_support tv_rs(&tv);
+
+    std::array<uint64_t, 3> ranks = {{0, 0, 0}};
+    for (uint64_t i = 0; i <= tv.get_num_trits(); ++i) {
+        auto r = tv_rs.rank_all(i);
+        if (ranks != r) {
+            std::cerr << "Error: RankAll(" << i << ") = (" << r[0] << ", " << r[1] << ", " << r[2]
+                      << "), but != (" << ranks[0] << ", " << ranks[1] << ", " << ranks[2] << ")" << std::endl;
+            return;
+        }
+        if (i < tv.get_num_trits()) {
+            ++ranks[tv[i]];
+        }
+    }
+    if (tv_rs.get_num_target_trits<0>() != ranks[0] || tv_rs.get_num_target_trits<1>() != ranks[1] ||
+        tv_rs.get_num_target_trits<2>() != ranks[2]) {
+        std::cerr << "Error: tv_rs.get_num_target_trits() is wrong" << std::endl;
+        return;
+    }
+
+    if (!test_fused_select<0>(tv_rs) || !test_fused_select<1>(tv_rs) || !test_fused_select<2>(tv_rs)) {
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+template <class Pred>
+bool test_predicate(const succinctrits::trit_vector& tv, const succinctrits::fused_rs_support& tv_rs, uint8_t mask,
+                    const char* name) {
+    uint64_t rank = 0;
+    for (uint64_t i = 0; i <= tv.get_num_trits(); ++i) {
+        if (tv_rs.rank_if<Pred>(i) != rank) {
+            std::cerr << "Error: RankIf<" << name << ">(" << i << ") = " << tv_rs.rank_if<Pred>(i) << ", but != "
+                      << rank << std::endl;
+            return false;
+        }
+        if (i < tv.get_num_trits() && (mask >> tv[i] & 1)) {
+            if (tv_rs.select_if<Pred>(rank) != i) {
+                std::cerr << "Error: SelectIf<" << name << ">(" << rank << ") = " << tv_rs.select_if<Pred>(rank)
+                          << ", but != " << i << std::endl;
+                return false;
+            }
+            ++rank;
+        }
+    }
+    if (tv_rs.get_num_target_trits_if<Pred>() != rank) {
+        std::cerr << "Error: get_num_target_trits_if<" << name << ">() is wrong" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void test_predicates(const succinctrits::trit_vector& tv) {
+    using namespace succinctrits;
+    fused_rs_support tv_rs(&tv);
+
+    if (!test_predicate<trit_eq<0>>(tv, tv_rs, 0b001, "eq 0") ||  //
+        !test_predicate<trit_eq<1>>(tv, tv_rs, 0b010, "eq 1") ||  //
+        !test_predicate<trit_eq<2>>(tv, tv_rs, 0b100, "eq 2") ||  //
+        !test_predicate<trit_ne<0>>(tv, tv_rs, 0b110, "ne 0") ||  //
+        !test_predicate<trit_ne<1>>(tv, tv_rs, 0b101, "ne 1") ||  //
+        !test_predicate<trit_ne<2>>(tv, tv_rs, 0b011, "ne 2") ||  //
+        !test_predicate<trit_lt<1>>(tv, tv_rs, 0b001, "lt 1") ||  //
+        !test_predicate<trit_lt<2>>(tv, tv_rs, 0b011, "lt 2")) {
+        return;
+    }
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
+// Checks the kernels of every ISA supported by the CPU against the scalar code.
+void test_dispatch(const std::vector<uint8_t>& trits, const succinctrits::trit_vector& tv) {
+    using succinctrits::isa;
+
+    std::random_device seed_gen;
+    std::default_random_engine engine(seed_gen());
+    std::uniform_int_distribution<uint32_t> byte_dist(0, 242);
+
+    succinctrits::rs_support<1> tv_rs(&tv);
+    const std::vector<uint8_t> head(trits.begin(), trits.begin() + 28003);
+
+    for (isa x : {isa::scalar, isa::sse42, isa::avx2, isa::avx512bw}) {
+        if (!succinctrits::set_isa(x)) {
+            continue;
+        }
+        const auto& kernels = succinctrits::detail::get_kernels();
+        const char* name = succinctrits::to_string(x);
+
+        if (x != isa::scalar) {
+            for (uint64_t r = 0; r < 1000; ++r) {
+                uint8_t trytes[16];
+                uint8_t digits[80];
+                for (uint64_t j = 0; j < 16; ++j) {
+                    trytes[j] = uint8_t(byte_dist(engine));
+                    for (uint64_t k = 0, v = trytes[j]; k < 5; ++k, v /= 3) {
+                        digits[j * 5 + k] = uint8_t(v % 3);
+                    }
+                }
+                for (uint8_t t = 0; t < 3; ++t) {
+                    uint64_t cnt = 0;
+                    for (uint64_t k = 0; k < 80; ++k) {
+                        if (kernels.count_trits[t](trytes, k) != cnt) {
+                            std::cerr << "Error: " << name << " count_trits<" << int(t) << ">(" << k
+                                      << ") != " << cnt << std::endl;
+                            return;
+                        }
+                        if (digits[k] == t) {
+                            uint64_t n = ++cnt;
+                            const uint64_t j = kernels.select_tryte[t](trytes, n);
+                            if (j != k / 5 || n != cnt - std::count(digits, digits + j * 5, t)) {
+                                std::cerr << "Error: " << name << " select_tryte<" << int(t) << ">(" << cnt
+                                          << ") = " << j << ", but != " << k / 5 << std::endl;
+                                return;
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::vector<uint16_t> values(70);
+            for (uint64_t len = 0; len <= values.size(); ++len) {
+                for (uint64_t j = 0; j < len; ++j) {
+                    values[j] = uint16_t(byte_dist(engine) * 256 + j);
+                }
+                std::sort(values.begin(), values.begin() + len);
+                const uint16_t y = uint16_t(byte_dist(engine) * 256);
+                const auto it = std::upper_bound(values.begin(), values.begin() + len, y);
+                const uint64_t expected = uint64_t(it - values.begin());
+                if (kernels.count_le_u16(values.data(), len, y) != expected) {
+                    std::cerr << "Error: " << name << " count_le_u16(" << len << ") != " << expected << std::endl;
+                    return;
+                }
+            }
+
+            for (uint64_t num_trytes = 0; num_trytes <= 200; ++num_trytes) {
+                std::vector<uint8_t> packed(num_trytes), unpacked(num_trytes * 5);
+                std::vector<uint8_t> input(trits.begin(), trits.begin() + num_trytes * 5);
+                if (!kernels.pack_trytes(input.data(), num_trytes, packed.data())) {
+                    std::cerr << "Error: " << name << " pack_trytes(" << num_trytes << ") is invalid" << std::endl;
+                    return;
+                }
+                kernels.unpack_trytes(packed.data(), num_trytes, unpacked.data());
+                if (!std::equal(input.begin(), input.begin() + num_trytes * 5, unpacked.begin())) {
+                    std::cerr << "Error: " << name << " pack_trytes(" << num_trytes << ") is not restored"
+                              << std::endl;
+                    return;
+                }
+                if (num_trytes != 0) {
+                    input[num_trytes * 5 - 1 - num_trytes % 5] = uint8_t(3 + num_trytes);
+                    if (kernels.pack_trytes(input.data(), num_trytes, packed.data())) {
+                        std::cerr << "Error: " << name << " pack_trytes(" << num_trytes << ") misses an invalid trit"
+                                  << std::endl;
+                        return;
+                    }
+                }
+            }
+        }
+
+        for (uint64_t i = 0; i < tv.get_num_trits(); i += 97) {
+            if (tv_rs.rank(i) != tv_rs.rank_scalar(i)) {
+                std::cerr << "Error: " << name << " Rank(" << i << ") != RankScalar(" << i << ")" << std::endl;
+                return;
+            }
+        }
+        for (uint64_t n = 0; n < tv_rs.get_num_target_trits(); n += 97) {
+            if (tv_rs.select(n) != tv_rs.select_scalar(n)) {
+                std::cerr << "Error: " << name << " Select(" << n << ") != SelectScalar(" << n << ")" << std::endl;
+                return;
+            }
+        }
+
+        std::vector<uint8_t> decoded(tv.get_num_trits() - 3);
+        tv.extract(3, tv.get_num_trits(), decoded.data());
+        if (!std::equal(decoded.begin(), decoded.end(), trits.begin() + 3)) {
+            std::cerr << "Error: " << name << " extract() is different" << std::endl;
+            return;
+        }
+        succinctrits::trit_vector encoded;
+        encoded.build_from_span(trits.data(), tv.get_num_trits());
+        for (uint64_t i = 0; i < tv.get_num_trits(); i += 13) {
+            if (encoded[i] != trits[i]) {
+                std::cerr << "Error: " << name << " build_from_span() is different at " << i << std::endl;
+                return;
+            }
+        }
+
+        succinctrits::interleaved_rs_vector<1> irv(head.begin(), head.size());
+        uint64_t rank = 0;
+        for (uint64_t i = 0; i < head.size(); ++i) {
+            if (irv.rank(i) != rank) {
+                std::cerr << "Error: " << name << " interleaved Rank(" << i << ") != " << rank << std::endl;
+                return;
+            }
+            if (head[i] == 1 && irv.select(rank++) != i) {
+                std::cerr << "Error: " << name << " interleaved Select(" << rank - 1 << ") != " << i << std::endl;
+                return;
+            }
+        }
+    }
+    succinctrits::set_isa(succinctrits::detect_isa());
+
+    std::cerr << "No Problem!" << std::endl;
+}
+
 int main() {
     auto trits = generate_trits();
     succinctrits::trit_vector tv(trits.begin(), trits.size());
@@ -72,5 +1507,64 @@ int main() {
     test_template<1>(tv);
     test_template<2>(tv);
 
+    test_select_samples<0>(tv, 1);
+    test_select_samples<1>(tv, 100);
+    test_select_samples<2>(tv, 512);
+
+    test_batch<0>(tv, 0);
+    test_batch<1>(tv, 512);
+
+    test_fused(tv);
+    test_predicates(tv);
+
+    // The last tryte is partially used
+    succinctrits::trit_vector tv_odd(trits.begin(), trits.size() - 3);
+    test_template<0>(tv_odd);
+    test_fused(tv_odd);
+    test_predicates(tv_odd);
+    test_template<1, succinctrits::rs_support<1, 65500, 100>>(tv_odd);
+    test_template<2, succinctrits::rs_support<2, 65520, 30>>(tv_odd);
+    test_template<0, succinctrits::rs_support<0, 250, 25, uint8_t>>(tv_odd);
+    test_block_params<1, succinctrits::rs_support<1, 65500, 100>>(tv_odd);
+    test_block_params<0, succinctrits::rs_support<0, 250, 25, uint8_t>>(tv_odd);
+    test_serialization(tv_odd);
+    test_container(tv_odd);
+    test_streaming_builder(trits, trits.size() - 3);
+    test_streaming_builder(trits, 13);
+    test_parallel_build(trits, trits.size() - 3);
+    test_extract(tv_odd);
+    test_occurrences<0>(tv_odd);
+    test_occurrences<2>(tv_odd);
+    test_append(std::vector<uint8_t>(trits.begin(), trits.end() - 3));
+    test_appendable(std::vector<uint8_t>(trits.begin(), trits.end() - 3));
+    test_dynamic(std::vector<uint8_t>(trits.begin(), trits.end() - 3));
+    test_packed<succinctrits::tryte_packing>(tv_odd);
+    test_packed<succinctrits::spill_packing>(tv_odd);
+
+    auto sparse_trits = generate_sparse_trits(NUM_TRITS, 2, 1000);
+    succinctrits::trit_vector tv_sparse(sparse_trits.begin(), sparse_trits.size());
+    test_select_samples<2>(tv_sparse, 64);
+    test_sparse<2>(tv_sparse);
+    test_occurrences<2>(tv_sparse);
+    test_sparse<0>(tv_odd);
+    test_next_prev<0>(tv_odd, succinctrits::rs_layout::dense);
+    test_next_prev<2>(tv_sparse, succinctrits::rs_layout::dense);
+    test_next_prev<2>(tv_sparse, succinctrits::rs_layout::sparse);
+    test_stats(tv_odd);
+    test_memory_resource(std::vector<uint8_t>(trits.begin(), trits.end() - 3));
+    test_interleaved<0>(std::vector<uint8_t>(trits.begin(), trits.end() - 3));
+    test_interleaved<1>(trits);
+    test_interleaved<2>(sparse_trits);
+    test_interleaved<0>(std::vector<uint8_t>(trits.begin(), trits.begin() + 2800));  // full lines
+    test_dispatch(trits, tv_odd);
+
+    test_rrr(std::vector<uint8_t>(trits.begin(), trits.end() - 3));
+    test_wavelet_matrix(100000, 1000);
+    test_wavelet_matrix(100003, 3);
+    test_wavelet_matrix(1000, 1);
+    test_wavelet_matrix(10000, UINT64_MAX);
+
+    test_rrr(generate_skewed_trits(NUM_TRITS - 3, 0, 40));  // 95% of 0s
+
     return 0;
 }
\ No newline at end of file